@@ -0,0 +1,23 @@
+//
+// Counting replacement of the global operator new, linked into the tools that report heap
+// allocations per parse (Stack, Benchmark). It is kept out of ParseDriver and the parser
+// libraries so that embedding them never replaces the host program's allocator.
+//
+#include <stdlib.h>
+#include <new>
+#include "ParseDriver.h"
+
+void* operator new(std::size_t size) {
+    allocation_count++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    free(p);
+}
@@ -0,0 +1,310 @@
+//
+// On-disk cache of the Grammar analysis used by Parser.cpp.
+//
+// An entry is addressed by a hash of the grammar as read (the IR's symbols and rules, so
+// whitespace and ε spelling do not matter), the options that change the transformations and
+// ZETA_ANALYSIS_CACHE_VERSION. It holds the transformed grammar, the FIRST and FOLLOW sets,
+// the parsing table and what the passes printed; a hit restores them into a Grammar without
+// running any pass or solver, and Parser replays the report so output.log reads the same.
+// Table images are not cached: they are rebuilt from the restored table, whatever the flags.
+//
+// Layout of <directory>/<key>.analysis (text, one record per line):
+//   zeta-analysis-cache <version>
+//   key <hash>
+//   input <bytes>          the grammar as read, serialized as below, compared on load
+//   report <bytes>         the grammars and reports the passes printed, verbatim
+//   grammar                the transformed grammar: symbols <n>, names, rules <n>, then per
+//                          rule "<id> <alternatives>" and "<length> <ids...>" per alternative
+//   first <n>              "<non-terminal> <count> <terminals...>" per non-terminal
+//   follow <n>
+//   table <n>              "<non-terminal> <terminal> <alternative>" per filled cell
+//   checksum <hash>        of every byte before this line
+//
+// Entries are written to a temporary file and renamed into place, so a reader never sees a
+// partial entry. Anything that does not validate is reported, ignored and overwritten by the
+// next store; entries of other grammars, options or versions are simply never looked up.
+// A hit refreshes the entry's modification time, and every store prunes the directory down to
+// the ZETA_ANALYSIS_CACHE_MAX_ENTRIES most recently used entries.
+//
+#ifndef ZETA_ANALYSIS_CACHE_H
+#define ZETA_ANALYSIS_CACHE_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <unistd.h>
+#include "Grammar.h"
+
+using namespace std;
+
+// Bump whenever a transformation, the FIRST/FOLLOW solvers or the table construction change
+// what they produce, so entries written by an older Parser stop being found.
+#define ZETA_ANALYSIS_CACHE_VERSION 2
+
+// Entries kept in a cache directory; the least recently used ones are removed beyond this
+#define ZETA_ANALYSIS_CACHE_MAX_ENTRIES 64
+
+// FNV-1a over 64 bits, for cache keys and entry checksums
+inline uint64_t analysisHash(const string& data, uint64_t h = 14695981039346656037ull) {
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+inline string hexHash(uint64_t h) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)h);
+    return buffer;
+}
+
+// Function to write the symbols and rules of an IR, independent of its arena layout
+inline string serializeIR(const GrammarIR& ir) {
+    ostringstream out;
+    out << "symbols " << ir.names.size() << "\n";
+    for (int id = 0; id < ir.names.size(); ++id) out << ir.names.name(id) << "\n";
+    out << "rules " << ir.size().rules << "\n";
+    for (size_t id = 0; id < ir.rules.size(); ++id) {
+        if (ir.rules[id].empty()) continue;
+        out << id << " " << ir.rules[id].size() << "\n";
+        for (const IRSpan& span : ir.rules[id]) {
+            out << span.length;
+            for (const int* it = ir.begin(span); it != ir.end(span); ++it) out << " " << *it;
+            out << "\n";
+        }
+    }
+    return out.str();
+}
+
+// Function to read an IR written by serializeIR; false if it is malformed
+inline bool deserializeIR(istream& in, GrammarIR& ir) {
+    string word, name;
+    int symbolCount = 0;
+    if (!(in >> word >> symbolCount) || word != "symbols" || symbolCount < 0) return false;
+    ir = GrammarIR();
+    getline(in, name);
+    for (int i = 0; i < symbolCount; ++i) {
+        if (!getline(in, name) || name.empty() || ir.symbol(name) != i) return false;
+    }
+    ir.rules.resize(symbolCount);
+
+    size_t ruleCount = 0;
+    if (!(in >> word >> ruleCount) || word != "rules") return false;
+    for (size_t r = 0; r < ruleCount; ++r) {
+        int lhs = -1;
+        size_t alternatives = 0;
+        if (!(in >> lhs >> alternatives) || lhs < 0 || lhs >= symbolCount || alternatives == 0 || !ir.rules[lhs].empty()) return false;
+        for (size_t a = 0; a < alternatives; ++a) {
+            size_t length = 0;
+            if (!(in >> length)) return false;
+            vector<int> body(length);
+            for (int& symbol : body) {
+                if (!(in >> symbol) || symbol < 0 || symbol >= symbolCount) return false;
+            }
+            ir.rules[lhs].push_back(ir.append({0, 0}, body));
+        }
+    }
+    return true;
+}
+
+class AnalysisCache {
+public:
+    explicit AnalysisCache(string directory) : directory(std::move(directory)) {}
+
+    // Function to key the entry by the grammar as read and the options that change the analysis
+    void open(const GrammarIR& input, const string& options) {
+        inputText = serializeIR(input);
+        string versioned = "zeta-analysis-cache " + to_string(ZETA_ANALYSIS_CACHE_VERSION) + "\n" + options + "\n";
+        key = hexHash(analysisHash(inputText, analysisHash(versioned)));
+    }
+
+    string path() const { return (filesystem::path(directory) / (key + ".analysis")).string(); }
+
+    // Function to restore the transformed grammar and its analysis into g and the passes' output
+    // into report. Returns false on a miss; an entry that exists but does not validate is
+    // reported and g is left untouched.
+    bool load(Grammar& g, string& report) const {
+        ifstream file(path(), ios::binary);
+        if (!file) return false;
+        string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        Grammar restored;
+        string restoredReport;
+        string reason = restore(data, restored, restoredReport);
+        if (!reason.empty()) {
+            cerr << "Warning: ignoring analysis cache entry " << path() << ": " << reason << endl;
+            return false;
+        }
+        restored.startIndex = restored.startSymbolIndex();
+        g = std::move(restored);
+        report = std::move(restoredReport);
+
+        // mark the entry as used, so pruning removes the ones nobody has read for longest
+        error_code ec;
+        filesystem::last_write_time(path(), filesystem::file_time_type::clock::now(), ec);
+        return true;
+    }
+
+    // Function to write g's transformed grammar, sets and table and the passes' report as the
+    // entry of this key
+    bool store(const Grammar& g, const string& report) const {
+        ostringstream out;
+        out << "zeta-analysis-cache " << ZETA_ANALYSIS_CACHE_VERSION << "\n";
+        out << "key " << key << "\n";
+        out << "input " << inputText.size() << "\n" << inputText;
+        out << "report " << report.size() << "\n" << report << "\n";
+        out << "grammar\n" << serializeIR(g.ir);
+        for (const BitMatrix* sets : {&g.firstSets, &g.followSets}) {
+            out << (sets == &g.firstSets ? "first " : "follow ") << g.nonTerminals.size() << "\n";
+            for (const string& nonTerm : g.nonTerminals) {
+                vector<int> members = g.sortedMembers(sets->row(g.nonTerminalIndex(g.symbols.lookup(nonTerm))));
+                out << nonTerm << " " << members.size();
+                for (int term : members) out << " " << g.symbols.name(term);
+                out << "\n";
+            }
+        }
+        out << "table " << g.tableCellCount() << "\n";
+        for (size_t nt = 0; nt < g.tableRows.size(); ++nt) {
+            for (const auto& [term, production] : g.tableRows[nt]) {
+                out << g.symbols.name(g.terminalCount + (int)nt) << " " << g.symbols.name(term) << " " << production - g.ruleOffsets[nt] << "\n";
+            }
+        }
+        string data = out.str();
+        data += "checksum " + hexHash(analysisHash(data)) + "\n";
+
+        // write beside the entry and rename over it, so concurrent runs only ever see whole files
+        error_code ec;
+        filesystem::create_directories(directory, ec);
+        string temporary = path() + ".tmp" + to_string(getpid());
+        ofstream file(temporary, ios::binary);
+        file.write(data.data(), (streamsize)data.size());
+        file.close();
+        if (!ec && !file.fail()) {
+            filesystem::rename(temporary, path(), ec);
+            if (!ec) {
+                prune();
+                return true;
+            }
+        }
+        filesystem::remove(temporary, ec);
+        cerr << "Warning: could not write analysis cache entry " << path() << endl;
+        return false;
+    }
+
+private:
+    string directory;
+    string key;
+    string inputText;
+
+    // Function to remove all but the ZETA_ANALYSIS_CACHE_MAX_ENTRIES most recently used entries,
+    // and temporary files an interrupted store left behind. Best effort: entries another run
+    // removes or replaces meanwhile are skipped.
+    void prune() const {
+        error_code ec;
+        vector<pair<filesystem::file_time_type, filesystem::path>> entries;
+        const auto staleBefore = filesystem::file_time_type::clock::now() - chrono::hours(1);
+        for (filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            const filesystem::path& file = it->path();
+            string name = file.filename().string();
+            filesystem::file_time_type written = it->last_write_time(ec);
+            if (ec) {
+                ec.clear();
+                continue;
+            }
+            if (file.extension() == ".analysis") {
+                entries.emplace_back(written, file);
+            } else if (name.find(".analysis.tmp") != string::npos && written < staleBefore) {
+                filesystem::remove(file, ec);
+                ec.clear();
+            }
+        }
+        if (entries.size() <= ZETA_ANALYSIS_CACHE_MAX_ENTRIES) return;
+        sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = ZETA_ANALYSIS_CACHE_MAX_ENTRIES; i < entries.size(); ++i) {
+            if (entries[i].second == filesystem::path(path())) continue;
+            filesystem::remove(entries[i].second, ec);
+        }
+    }
+
+    // Function to parse and check an entry; returns why it was rejected, or "" if g now holds it
+    string restore(const string& data, Grammar& g, string& report) const {
+        size_t checksumAt = data.rfind("checksum ");
+        if (checksumAt == string::npos || (checksumAt > 0 && data[checksumAt - 1] != '\n')) return "truncated";
+        if (data.compare(checksumAt, string::npos, "checksum " + hexHash(analysisHash(data.substr(0, checksumAt))) + "\n") != 0) {
+            return "checksum mismatch";
+        }
+
+        istringstream in(data.substr(0, checksumAt));
+        string word, value;
+        int version = 0;
+        if (!(in >> word >> version) || word != "zeta-analysis-cache" || version != ZETA_ANALYSIS_CACHE_VERSION) return "version mismatch";
+        if (!(in >> word >> value) || word != "key" || value != key) return "key mismatch";
+
+        size_t inputSize = 0;
+        if (!(in >> word >> inputSize) || word != "input" || in.get() != '\n') return "malformed input section";
+        string input(inputSize, '\0');
+        if (!in.read(input.data(), (streamsize)inputSize) || input != inputText) return "written for a different grammar";
+
+        size_t reportSize = 0;
+        if (!(in >> word >> reportSize) || word != "report" || in.get() != '\n' || reportSize > data.size()) return "malformed report";
+        report.assign(reportSize, '\0');
+        if (!in.read(report.data(), (streamsize)reportSize) || in.get() != '\n') return "malformed report";
+
+        if (!(in >> word) || word != "grammar" || !deserializeIR(in, g.ir)) return "malformed grammar";
+        g.initializeSymbols();
+        g.internSymbols();
+        const size_t nonTermCount = g.idRules.size();
+
+        // FIRST then FOLLOW: every non-terminal once, members must be terminals
+        for (BitMatrix* sets : {&g.firstSets, &g.followSets}) {
+            const string section = sets == &g.firstSets ? "first" : "follow";
+            size_t rows = 0;
+            if (!(in >> word >> rows) || word != section || rows != nonTermCount) return "malformed " + section + " sets";
+            sets->reset(nonTermCount, g.terminalCount);
+            vector<char> seen(nonTermCount, 0);
+            for (size_t r = 0; r < rows; ++r) {
+                size_t members = 0;
+                if (!(in >> value >> members)) return "malformed " + section + " sets";
+                int id = g.symbols.lookup(value);
+                if (id < 0 || g.isTerminal(id) || seen[g.nonTerminalIndex(id)]++) return "unknown non-terminal " + value;
+                for (size_t m = 0; m < members; ++m) {
+                    int term = (in >> value) ? g.symbols.lookup(value) : -1;
+                    if (term < 0 || !g.isTerminal(term)) return "unknown terminal in " + section + " sets";
+                    setBit(sets->row(g.nonTerminalIndex(id)), term);
+                }
+            }
+        }
+
+        size_t cells = 0;
+        if (!(in >> word >> cells) || word != "table") return "malformed table";
+        g.terminals.insert("$");
+        g.tableRows.assign(nonTermCount, TableRow());
+        for (size_t c = 0; c < cells; ++c) {
+            string nonTerm, term;
+            size_t alternative = 0;
+            if (!(in >> nonTerm >> term >> alternative)) return "malformed table";
+            int nt = g.symbols.lookup(nonTerm), t = g.symbols.lookup(term);
+            if (nt < 0 || g.isTerminal(nt) || t <= Grammar::EPSILON_ID || !g.isTerminal(t)) return "unknown symbol in table";
+            nt = g.nonTerminalIndex(nt);
+            if (alternative >= g.idRules[nt].size()) return "production out of range in table";
+            int production = g.ruleOffsets[nt] + (int)alternative;
+            TableRow& row = g.tableRows[nt];
+            if (!row.empty() && row.back().first >= t) return "table cells out of order";
+            row.emplace_back(t, production);
+            g.parsingTable[make_pair(nonTerm, term)] = g.productionTexts[production];
+        }
+        if (in >> word) return "trailing data";
+        return "";
+    }
+};
+
+#endif // ZETA_ANALYSIS_CACHE_H
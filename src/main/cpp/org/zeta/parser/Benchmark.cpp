@@ -0,0 +1,342 @@
+//
+// Benchmarks for the grammar analysis (Grammar.h) and the parse driver (ParseDriver.h).
+//
+// For every grammar size a synthetic grammar is generated and run through each Grammar
+// phase separately; its compiled table is then loaded the way Stack loads it and used to
+// parse generated input of every requested length, once dense and once with the compressed
+// action table (with the size of both and the cost of a lookup). Results are printed as JSON.
+//
+// usage: Benchmark [--sizes=4,16,64] [--tokens=10000,100000,1000000] [--repeat=5] [--output=FILE]
+//
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include "Grammar.h"
+#include "ParseDriver.h"
+
+using namespace std;
+
+#define BENCHMARK_FORMAT_VERSION 2
+#define LOOKUP_COUNT 1000000
+
+// discards everything written to it, used to silence the Grammar phases while timing
+class NullBuf : public streambuf {
+protected:
+    int overflow(int c) override { return c == EOF ? 0 : c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+// Timings of one measurement, repeated
+struct Samples {
+    vector<double> values;
+
+    double median() const {
+        vector<double> sorted = values;
+        sort(sorted.begin(), sorted.end());
+        return sorted.empty() ? 0.0 : sorted[sorted.size() / 2];
+    }
+    double min() const {
+        return values.empty() ? 0.0 : *min_element(values.begin(), values.end());
+    }
+};
+
+// Function to measure the milliseconds taken by f
+template <typename F>
+double timeMs(F&& f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Function to generate a grammar with `size` left-recursive precedence levels and `size`
+// statement kinds, shaped like the Zeta grammar:
+//   P  -> S P | ε
+//   S  -> kwJ id = E0 ;                       for each statement kind J
+//   Ei -> Ei opI Ei+1 | Ei+1                  for each level I
+//   En -> id | num | ( E0 )
+string generateGrammar(int size) {
+    ostringstream out;
+    out << "P -> S P | ε\n";
+    out << "S ->";
+    for (int j = 0; j < size; ++j) out << (j ? " |" : "") << " kw" << j << " id = E0 ;";
+    out << "\n";
+    for (int i = 0; i < size; ++i) {
+        out << "E" << i << " -> E" << i << " op" << i << " E" << i + 1 << " | E" << i + 1 << "\n";
+    }
+    out << "E" << size << " -> id | num | ( E0 )\n";
+    return out.str();
+}
+
+// Function to append a random expression of the generated grammar, starting at `level`
+void generateExpression(int size, int level, int depth, mt19937& rng, vector<string>& tokens) {
+    if (level == size) {
+        uniform_int_distribution<int> pick(0, 9);
+        int p = pick(rng);
+        if (p == 0 && depth < 3) {
+            tokens.push_back("(");
+            generateExpression(size, 0, depth + 1, rng, tokens);
+            tokens.push_back(")");
+        } else {
+            tokens.push_back(p % 2 ? "id" : "num");
+        }
+        return;
+    }
+    // about one operator per expression whatever the depth of the grammar
+    bernoulli_distribution extend(1.0 / size);
+    int count = 0;
+    while (count < 2 && extend(rng)) count++;
+    generateExpression(size, level + 1, depth, rng, tokens);
+    for (int k = 0; k < count; ++k) {
+        tokens.push_back("op" + to_string(level));
+        generateExpression(size, level + 1, depth, rng, tokens);
+    }
+}
+
+// Function to generate input lines of several statements each, about `targetTokens` tokens in total
+string generateInput(int size, size_t targetTokens, size_t& tokenCount, size_t& lineCount) {
+    mt19937 rng(12345);
+    uniform_int_distribution<int> kind(0, size - 1);
+    uniform_int_distribution<int> statementsPerLine(1, 8);
+    string input;
+    tokenCount = lineCount = 0;
+    vector<string> tokens;
+    while (tokenCount < targetTokens) {
+        tokens.clear();
+        int statements = statementsPerLine(rng);
+        for (int k = 0; k < statements; ++k) {
+            tokens.push_back("kw" + to_string(kind(rng)));
+            tokens.push_back("id");
+            tokens.push_back("=");
+            generateExpression(size, 0, 0, rng, tokens);
+            tokens.push_back(";");
+        }
+        input += joinTokens(tokens);
+        input += '\n';
+        tokenCount += tokens.size();
+        lineCount++;
+    }
+    return input;
+}
+
+// Function to format a double for JSON
+string jsonNumber(double value) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.6g", value);
+    return buffer;
+}
+
+// Function to format a set of samples as {"median_ms":..,"min_ms":..}
+string jsonSamples(const Samples& samples) {
+    return "{\"median_ms\": " + jsonNumber(samples.median()) + ", \"min_ms\": " + jsonNumber(samples.min()) + "}";
+}
+
+// Function to split "1,2,3" into numbers
+vector<long long> parseList(const string& text) {
+    vector<long long> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(stoll(item));
+    }
+    return values;
+}
+
+// Function to time get_production over random (non-terminal, terminal) cells, in ns per lookup
+double lookupNs(const ParsingTable& table, int repeat) {
+    mt19937 rng(777);
+    uniform_int_distribution<int> nt(table.num_terminals, table.num_terminals + table.num_nonterminals - 1);
+    uniform_int_distribution<int> term(0, table.num_terminals - 1);
+    vector<pair<int, int>> cells(LOOKUP_COUNT);
+    for (auto& cell : cells) cell = {nt(rng), term(rng)};
+
+    Samples samples;
+    volatile long long sink = 0;
+    for (int r = 0; r < repeat; ++r) {
+        samples.values.push_back(timeMs([&] {
+            long long sum = 0;
+            for (const auto& cell : cells) sum += get_production(&table, cell.first, cell.second);
+            sink = sink + sum;
+        }));
+    }
+    return samples.median() * 1e6 / LOOKUP_COUNT;
+}
+
+// Function to parse the whole input once per repetition, returning the timings and the totals of the last run
+Samples timeParse(const ParsingTable& table, const string& input, int repeat, ParseTotals& totals) {
+    Samples parseTimes;
+    for (int r = 0; r < repeat; ++r) {
+        ParseWorker worker;
+        worker_init(&worker);
+        TokenReader reader;
+        reader_open_range(&reader, input.data(), input.data() + input.size(), 0);
+        parseTimes.values.push_back(timeMs([&] {
+            while (reader_next_line(&reader)) parse_input(&table, &worker, &reader);
+        }));
+        totals = worker.totals;
+        reader_close(&reader);
+        worker_free(&worker);
+    }
+    return parseTimes;
+}
+
+// Function to benchmark one grammar size, returning its JSON object
+string benchmarkGrammar(int size, const vector<long long>& tokenCounts, int repeat) {
+    const string grammarFile = "benchmark_cfg.txt";
+    const string csvFile = "benchmark_table.csv";
+    const string binaryFile = "benchmark_table.bin";
+    const string compressedFile = "benchmark_table_compressed.bin";
+    {
+        ofstream out(grammarFile);
+        out << generateGrammar(size);
+    }
+
+    // Grammar phases, each repetition on a fresh Grammar
+    const vector<string> phases = {"readGrammar", "leftFactoring", "leftRecursion", "computeFirst",
+                                   "computeFollow", "computeParsingTable", "writeParsingTableToCSV",
+                                   "writeParsingTableToBinary", "replaceProduction"};
+    vector<Samples> phaseTimes(phases.size());
+    size_t nonTerminals = 0, terminals = 0, productions = 0;
+
+    NullBuf nullBuf;
+    streambuf* originalCout = cout.rdbuf(&nullBuf);
+    streambuf* originalCerr = cerr.rdbuf(&nullBuf);
+    for (int r = 0; r < repeat; ++r) {
+        Grammar g;
+        phaseTimes[0].values.push_back(timeMs([&] { g.readGrammar(grammarFile); }));
+        phaseTimes[1].values.push_back(timeMs([&] { g.leftFactoring(); }));
+        phaseTimes[2].values.push_back(timeMs([&] { g.leftRecursion(); }));
+        phaseTimes[3].values.push_back(timeMs([&] { g.computeFirst(); }));
+        phaseTimes[4].values.push_back(timeMs([&] { g.computeFollow(); }));
+        phaseTimes[5].values.push_back(timeMs([&] { g.computeParsingTable(); }));
+        phaseTimes[6].values.push_back(timeMs([&] { g.writeParsingTableToCSV(csvFile); }));
+        phaseTimes[7].values.push_back(timeMs([&] { g.writeParsingTableToBinary(binaryFile); }));
+        // an incremental edit of one statement kind; replacing the production by itself still
+        // recomputes everything that depends on S
+        size_t s = g.nonTerminalIndex(g.symbols.lookup("S"));
+        string statement = g.productionTexts[g.ruleOffsets[s] + g.idRules[s].size() / 2];
+        GrammarEdit edit;
+        phaseTimes[8].values.push_back(timeMs([&] { g.replaceProduction("S", statement, statement, edit); }));
+        nonTerminals = g.nonTerminals.size();
+        terminals = g.terminals.size();
+        productions = g.productionCount();
+        if (r == repeat - 1) g.writeParsingTableToBinary(compressedFile, ZLL1_FLAG_COMPRESSED_ACTIONS);
+    }
+    cout.rdbuf(originalCout);
+    cerr.rdbuf(originalCerr);
+
+    // Table loading as done by Stack
+    Samples binaryLoad, csvLoad;
+    for (int r = 0; r < repeat; ++r) {
+        ParsingTable table = {};
+        binaryLoad.values.push_back(timeMs([&] { load_parsing_table_binary(&table, binaryFile.c_str()); }));
+        unload_parsing_table(&table);
+        csvLoad.values.push_back(timeMs([&] { load_parsing_table(&table, csvFile.c_str()); }));
+        unload_parsing_table(&table);
+    }
+
+    // Dense and compressed action tables: size and lookup cost
+    ParsingTable table = {}, compressed = {};
+    if (!load_parsing_table_binary(&table, binaryFile.c_str()) || !load_parsing_table_binary(&compressed, compressedFile.c_str())) {
+        cerr << "Error: could not load " << binaryFile << " or " << compressedFile << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t denseBytes = table.header->productions_offset - table.header->actions_offset;
+    size_t compressedBytes = compressed.header->productions_offset - compressed.header->actions_offset;
+    string tableJson = "{\"dense_bytes\": " + to_string(denseBytes) + ", \"compressed_bytes\": " + to_string(compressedBytes)
+                       + ", \"ratio\": " + jsonNumber((double)denseBytes / compressedBytes)
+                       + ", \"dense_lookup_ns\": " + jsonNumber(lookupNs(table, repeat))
+                       + ", \"compressed_lookup_ns\": " + jsonNumber(lookupNs(compressed, repeat)) + "}";
+
+    // Parse throughput over the generated input lengths
+    string parses;
+    for (size_t t = 0; t < tokenCounts.size(); ++t) {
+        size_t tokenCount, lineCount;
+        string input = generateInput(size, (size_t)tokenCounts[t], tokenCount, lineCount);
+
+        ParseTotals totals = {0, 0, 0, 0}, compressedTotals = {0, 0, 0, 0};
+        Samples parseTimes = timeParse(table, input, repeat, totals);
+        Samples compressedTimes = timeParse(compressed, input, repeat, compressedTotals);
+
+        double seconds = parseTimes.median() / 1000.0;
+        parses += string(t ? ",\n" : "") + "        {\"tokens\": " + to_string(tokenCount)
+                  + ", \"lines\": " + to_string(lineCount)
+                  + ", \"accepted\": " + to_string(totals.accepted)
+                  + ", \"steps\": " + to_string(totals.steps)
+                  + ", \"parse\": " + jsonSamples(parseTimes)
+                  + ", \"tokens_per_second\": " + jsonNumber(seconds > 0 ? tokenCount / seconds : 0.0)
+                  + ", \"ns_per_token\": " + jsonNumber(parseTimes.median() * 1e6 / tokenCount)
+                  + ", \"compressed_parse\": " + jsonSamples(compressedTimes)
+                  + ", \"compressed_ns_per_token\": " + jsonNumber(compressedTimes.median() * 1e6 / tokenCount) + "}";
+        if (compressedTotals.accepted != totals.accepted || compressedTotals.steps != totals.steps) {
+            cerr << "Warning: size " << size << ": the compressed table parsed differently" << endl;
+        }
+        if (totals.accepted != lineCount) {
+            cerr << "Warning: size " << size << ": " << lineCount - totals.accepted << " generated lines were rejected" << endl;
+        }
+    }
+    unload_parsing_table(&table);
+    unload_parsing_table(&compressed);
+
+    remove(grammarFile.c_str());
+    remove(csvFile.c_str());
+    remove(binaryFile.c_str());
+    remove(compressedFile.c_str());
+
+    string json = "    {\"size\": " + to_string(size) + ", \"non_terminals\": " + to_string(nonTerminals)
+                  + ", \"terminals\": " + to_string(terminals) + ", \"productions\": " + to_string(productions) + ",\n";
+    json += "      \"phases\": {";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        json += string(i ? ", " : "") + "\"" + phases[i] + "\": " + jsonSamples(phaseTimes[i]);
+    }
+    json += "},\n";
+    json += "      \"action_table\": " + tableJson + ",\n";
+    json += "      \"table_load\": {\"binary\": " + jsonSamples(binaryLoad) + ", \"csv\": " + jsonSamples(csvLoad) + "},\n";
+    json += "      \"parse\": [\n" + parses + "\n      ]}";
+    return json;
+}
+
+int main(int argc, char* argv[]) {
+    vector<long long> sizes = {4, 16, 64};
+    vector<long long> tokenCounts = {10000, 100000, 1000000};
+    int repeat = 5;
+    string outputFile;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--sizes=", 0) == 0) sizes = parseList(arg.substr(8));
+        else if (arg.rfind("--tokens=", 0) == 0) tokenCounts = parseList(arg.substr(9));
+        else if (arg.rfind("--repeat=", 0) == 0) repeat = stoi(arg.substr(9));
+        else if (arg.rfind("--output=", 0) == 0) outputFile = arg.substr(9);
+        else {
+            cerr << "usage: " << argv[0] << " [--sizes=4,16,64] [--tokens=10000,100000,1000000] [--repeat=5] [--output=FILE]" << endl;
+            return 1;
+        }
+    }
+    if (repeat < 1 || sizes.empty() || *min_element(sizes.begin(), sizes.end()) < 1) {
+        cerr << "Error: sizes and repeat must be at least 1." << endl;
+        return 1;
+    }
+    trace_level = TRACE_LEVEL_SILENT;
+
+    string json = "{\n  \"format\": " + to_string(BENCHMARK_FORMAT_VERSION) + ",\n  \"repeat\": " + to_string(repeat) + ",\n  \"grammars\": [\n";
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        cerr << "Benchmarking grammar size " << sizes[i] << "..." << endl;
+        json += string(i ? ",\n" : "") + benchmarkGrammar((int)sizes[i], tokenCounts, repeat);
+    }
+    json += "\n  ]\n}\n";
+
+    if (outputFile.empty()) {
+        cout << json;
+    } else {
+        ofstream out(outputFile);
+        out << json;
+        cerr << "Results saved to " << outputFile << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,459 @@
+//
+// Compile-time version of the Grammar analysis: a grammar literal in the cfg.txt format is
+// read, freed of immediate left recursion, analyzed (nullable, FIRST, FOLLOW) and turned into
+// an LL(1) table entirely during constant evaluation. The result is a constexpr object in the
+// layout of ParseTableFormat.h, so it lands in .rodata and is used in place like a mapped file:
+//
+//     using Builtin = zeta::ConstexprGrammar<"E -> E + T | T\nT -> id | ( E )">;
+//     attach(Builtin::header(), Builtin::size());
+//
+// Symbols, production numbering and production texts follow Parser.cpp (cfg order is sorted by
+// LHS, left recursion becomes A -> β A' and A' -> α A' | ε). Left factoring and grammar
+// reduction are not done here, so the literal must already be left-factored and free of dead
+// or duplicate rules. A malformed literal or an LL(1) conflict is a compile error naming the
+// problem through a GrammarError<...> template argument.
+// The analysis favours simplicity over speed; grammars much larger than a few dozen rules may
+// need a higher -fconstexpr-ops-limit.
+//
+#ifndef ZETA_CONSTEXPR_GRAMMAR_H
+#define ZETA_CONSTEXPR_GRAMMAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "ParseTableFormat.h"
+
+#define CONSTEXPR_GRAMMAR_MESSAGE_SIZE 160
+
+namespace zeta {
+
+// String literal usable as a template argument
+template <size_t N>
+struct FixedString {
+    char text[N] = {};
+
+    constexpr FixedString(const char (&s)[N]) {
+        for (size_t i = 0; i < N; ++i) text[i] = s[i];
+    }
+    constexpr std::string_view view() const { return std::string_view(text, N - 1); }
+};
+
+// Diagnostic carried into a template argument, so the compiler prints it
+struct GrammarMessage {
+    char text[CONSTEXPR_GRAMMAR_MESSAGE_SIZE] = {};
+};
+
+// Deliberately never defined: naming it for a bad grammar fails the build with the message
+template <GrammarMessage Message>
+struct GrammarError;
+
+namespace detail {
+
+// Text built during constant evaluation. std::vector<char> rather than std::string: GCC 12
+// rejects moving short std::strings while a vector of them grows in a constant expression.
+using Text = std::vector<char>;
+
+constexpr std::string_view view(const Text& t) { return std::string_view(t.data(), t.size()); }
+
+constexpr Text text(std::string_view s) { return Text(s.begin(), s.end()); }
+
+constexpr Text concat(std::string_view a, std::string_view b, std::string_view c = {}) {
+    Text t = text(a);
+    t.insert(t.end(), b.begin(), b.end());
+    t.insert(t.end(), c.begin(), c.end());
+    return t;
+}
+
+constexpr Text number(size_t n) {
+    Text digits;
+    do digits.insert(digits.begin(), (char)('0' + n % 10));
+    while (n /= 10);
+    return digits;
+}
+
+constexpr bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// whitespace-separated tokens, like reading with istringstream >>
+constexpr std::vector<std::string_view> tokenize(std::string_view s) {
+    std::vector<std::string_view> tokens;
+    size_t i = 0;
+    while (i < s.size()) {
+        while (i < s.size() && isSpace(s[i])) ++i;
+        size_t start = i;
+        while (i < s.size() && !isSpace(s[i])) ++i;
+        if (i > start) tokens.push_back(s.substr(start, i - start));
+    }
+    return tokens;
+}
+
+// symbols joined by single spaces, ε dropped, and "ε" for an empty RHS, as GrammarIR::text prints it
+constexpr Text productionText(std::string_view prodStr) {
+    Text result;
+    for (std::string_view token : tokenize(prodStr)) {
+        if (token == "ε") continue;
+        if (!result.empty()) result.push_back(' ');
+        result.insert(result.end(), token.begin(), token.end());
+    }
+    if (result.empty()) return text("ε");
+    return result;
+}
+
+// One rule of the cfg map: LHS and its alternatives as written
+struct Rule {
+    Text lhs;
+    std::vector<Text> alternatives;
+};
+
+// cfg[lhs], keeping rules sorted by LHS like std::map
+constexpr Rule& ruleFor(std::vector<Rule>& rules, std::string_view lhs) {
+    size_t i = 0;
+    while (i < rules.size() && view(rules[i].lhs) < lhs) ++i;
+    if (i == rules.size() || view(rules[i].lhs) != lhs) rules.insert(rules.begin() + (long)i, Rule{text(lhs), {}});
+    return rules[i];
+}
+
+struct Production {
+    int lhs;                       // symbol ID
+    std::vector<int> rhs;          // symbol IDs, grammar order
+    Text prodStr;                  // alternative as written
+};
+
+// Everything computed from the literal. IDs are those of the binary format: "$" is 0, then the
+// terminals in name order, then the non-terminals in name order.
+struct Analysis {
+    Text error;
+    std::vector<Text> names;
+    int terminalCount = 0;
+    int start = -1;
+    std::vector<Production> productions;
+    std::vector<int> actions;      // [(nt - terminalCount) * terminalCount + terminal]
+};
+
+constexpr Text describeRule(const Analysis& a, int production) {
+    const Production& p = a.productions[production];
+    return concat(view(a.names[p.lhs]), " -> ", view(productionText(view(p.prodStr))));
+}
+
+// readGrammar: "LHS -> alt | alt" per line (blank lines are skipped)
+constexpr void readRules(std::string_view source, std::vector<Rule>& rules, Text& error) {
+    size_t lineNumber = 0;
+    while (!source.empty()) {
+        size_t newline = source.find('\n');
+        std::string_view line = source.substr(0, newline);
+        source = newline == std::string_view::npos ? std::string_view() : source.substr(newline + 1);
+        ++lineNumber;
+
+        std::vector<std::string_view> words = tokenize(line);
+        if (words.empty()) continue;
+        if (words.size() < 2 || words[1] != "->") {
+            error = concat("invalid production format on line ", view(number(lineNumber)));
+            return;
+        }
+
+        // split the rest of the line on '|' (no trailing empty alternative, like getline)
+        std::string_view rhs = line.substr((size_t)(words[1].data() - line.data()) + 2);
+        Rule& rule = ruleFor(rules, words[0]);
+        while (!rhs.empty()) {
+            size_t bar = rhs.find('|');
+            rule.alternatives.push_back(text(rhs.substr(0, bar)));
+            rhs = bar == std::string_view::npos ? std::string_view() : rhs.substr(bar + 1);
+        }
+    }
+}
+
+// leftRecursion: A -> A α | β  becomes  A -> β A' and A' -> α A' | ε
+constexpr std::vector<Rule> removeLeftRecursion(const std::vector<Rule>& rules) {
+    std::vector<Rule> result;
+    for (const Rule& rule : rules) {
+        std::vector<Text> recursive, others;
+        for (const Text& prod : rule.alternatives) {
+            std::vector<std::string_view> symbols = tokenize(view(prod));
+            if (!symbols.empty() && symbols[0] == view(rule.lhs)) {
+                // α is the rest of the alternative after its first symbol, as written
+                size_t end = (size_t)(symbols[0].data() - prod.data()) + symbols[0].size();
+                recursive.push_back(text(view(prod).substr(end)));
+            } else {
+                others.push_back(prod);
+            }
+        }
+        if (recursive.empty()) {
+            ruleFor(result, view(rule.lhs)).alternatives = rule.alternatives;
+            continue;
+        }
+
+        Text newNonTerminal = concat(view(rule.lhs), "'");
+        if (others.empty()) others.push_back(text("ε"));
+        std::vector<Text> lhsProds, newProds;
+        for (const Text& beta : others) {
+            if (view(beta) != "ε") lhsProds.push_back(concat(view(beta), " ", view(newNonTerminal)));
+            else lhsProds.push_back(newNonTerminal);
+        }
+        for (const Text& alpha : recursive) newProds.push_back(concat(view(alpha), " ", view(newNonTerminal)));
+        newProds.push_back(text("ε"));
+        ruleFor(result, view(rule.lhs)).alternatives = lhsProds;
+        ruleFor(result, view(newNonTerminal)).alternatives = newProds;
+    }
+    return result;
+}
+
+constexpr Analysis analyze(std::string_view source) {
+    Analysis a;
+    std::vector<Rule> rules;
+    readRules(source, rules, a.error);
+    if (!a.error.empty()) return a;
+    if (rules.empty()) {
+        a.error = text("the grammar has no rules");
+        return a;
+    }
+    rules = removeLeftRecursion(rules);
+
+    auto ruleIndex = [&rules](std::string_view name) {
+        for (size_t i = 0; i < rules.size(); ++i) if (view(rules[i].lhs) == name) return (int)i;
+        return -1;
+    };
+
+    // Symbols: $, sorted terminals, then the non-terminals (already sorted)
+    std::vector<Text> terminals;
+    for (const Rule& rule : rules) {
+        for (const Text& prod : rule.alternatives) {
+            for (std::string_view token : tokenize(view(prod))) {
+                if (token == "ε" || ruleIndex(token) >= 0) continue;
+                size_t i = 0;
+                while (i < terminals.size() && view(terminals[i]) < token) ++i;
+                if (i == terminals.size() || view(terminals[i]) != token) terminals.insert(terminals.begin() + (long)i, text(token));
+            }
+        }
+    }
+    a.names.push_back(text("$"));
+    for (const Text& t : terminals) a.names.push_back(t);
+    a.terminalCount = (int)a.names.size();
+    for (const Rule& rule : rules) a.names.push_back(rule.lhs);
+
+    auto idOf = [&a](std::string_view name) {
+        for (size_t id = 0; id < a.names.size(); ++id) if (view(a.names[id]) == name) return (int)id;
+        return -1;
+    };
+    for (size_t nt = 0; nt < rules.size(); ++nt) {
+        for (const Text& prod : rules[nt].alternatives) {
+            Production p{a.terminalCount + (int)nt, {}, prod};
+            for (std::string_view token : tokenize(view(prod))) {
+                if (token != "ε") p.rhs.push_back(idOf(token));
+            }
+            a.productions.push_back(p);
+        }
+    }
+    // P if there is one, otherwise the first LHS (startSymbolIndex)
+    a.start = ruleIndex("P") >= 0 ? idOf("P") : a.terminalCount;
+
+    // nullable, FIRST and FOLLOW by fixed-point iteration; the grammar is small
+    const int n = (int)rules.size();
+    const int t = a.terminalCount;
+    std::vector<bool> nullable(n, false);
+    std::vector<std::vector<bool>> first(n, std::vector<bool>(t, false));
+    std::vector<std::vector<bool>> follow(n, std::vector<bool>(t, false));
+
+    // FIRST of rhs[from..] into out; returns true if that suffix is nullable
+    auto firstOfSequence = [&](const std::vector<int>& rhs, size_t from, std::vector<bool>& out) {
+        for (size_t i = from; i < rhs.size(); ++i) {
+            if (rhs[i] < t) {
+                out[rhs[i]] = true;
+                return false;
+            }
+            const std::vector<bool>& f = first[rhs[i] - t];
+            for (int k = 0; k < t; ++k) if (f[k]) out[k] = true;
+            if (!nullable[rhs[i] - t]) return false;
+        }
+        return true;
+    };
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const Production& p : a.productions) {
+            int lhs = p.lhs - t;
+            std::vector<bool> f = first[lhs];
+            bool derivesEpsilon = firstOfSequence(p.rhs, 0, f);
+            if (f != first[lhs]) {
+                first[lhs] = f;
+                changed = true;
+            }
+            if (derivesEpsilon && !nullable[lhs]) {
+                nullable[lhs] = true;
+                changed = true;
+            }
+        }
+    }
+
+    follow[a.start - t][0] = true;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const Production& p : a.productions) {
+            for (size_t i = 0; i < p.rhs.size(); ++i) {
+                if (p.rhs[i] < t) continue;
+                std::vector<bool> f = follow[p.rhs[i] - t];
+                if (firstOfSequence(p.rhs, i + 1, f)) {
+                    const std::vector<bool>& followLhs = follow[p.lhs - t];
+                    for (int k = 0; k < t; ++k) if (followLhs[k]) f[k] = true;
+                }
+                if (f != follow[p.rhs[i] - t]) {
+                    follow[p.rhs[i] - t] = f;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Table: FIRST(α), plus FOLLOW(A) when α is nullable. Two different alternatives in one cell
+    // is a conflict (identical alternatives are not, as in computeParsingTable).
+    a.actions.assign((size_t)n * t, ZLL1_NO_PRODUCTION);
+    for (size_t p = 0; p < a.productions.size(); ++p) {
+        const Production& prod = a.productions[p];
+        std::vector<bool> lookaheads(t, false);
+        if (firstOfSequence(prod.rhs, 0, lookaheads)) {
+            const std::vector<bool>& followLhs = follow[prod.lhs - t];
+            for (int k = 0; k < t; ++k) if (followLhs[k]) lookaheads[k] = true;
+        }
+        for (int k = 0; k < t; ++k) {
+            if (!lookaheads[k]) continue;
+            int& cell = a.actions[(size_t)(prod.lhs - t) * t + k];
+            if (cell != ZLL1_NO_PRODUCTION && a.productions[cell].rhs != prod.rhs && a.error.empty()) {
+                a.error = concat("LL(1) conflict in M[", view(a.names[prod.lhs]), ", ");
+                a.error = concat(view(a.error), view(a.names[k]), "]: ");
+                a.error = concat(view(a.error), view(describeRule(a, cell)), " | ");
+                a.error = concat(view(a.error), view(describeRule(a, (int)p)));
+            }
+            cell = (int)p;
+        }
+    }
+    return a;
+}
+
+// Section sizes of the compiled table, and the diagnostic if there is none
+struct Summary {
+    bool ok = false;
+    GrammarMessage message;
+    size_t symbols = 0;
+    size_t terminals = 0;
+    size_t strings = 0;
+    size_t buckets = 0;
+    size_t actions = 0;
+    size_t productions = 0;
+    size_t rhs = 0;
+};
+
+constexpr Summary summarize(std::string_view source) {
+    Analysis a = analyze(source);
+    Summary s;
+    s.ok = a.error.empty();
+    for (size_t i = 0; i < a.error.size() && i + 1 < CONSTEXPR_GRAMMAR_MESSAGE_SIZE; ++i) s.message.text[i] = a.error[i];
+    if (!s.ok) return s;
+
+    s.symbols = a.names.size();
+    s.terminals = (size_t)a.terminalCount;
+    for (const Text& name : a.names) s.strings += name.size() + 1;
+    for (const Production& p : a.productions) {
+        s.strings += productionText(view(p.prodStr)).size() + 1;
+        s.rhs += p.rhs.size();
+    }
+    s.buckets = 16;
+    while (s.buckets < 2 * s.symbols + 1) s.buckets *= 2;
+    s.actions = a.actions.size();
+    s.productions = a.productions.size();
+    return s;
+}
+
+constexpr size_t atLeastOne(size_t n) { return n ? n : 1; }
+
+// The compiled table as one typed object; the header's offsets point at its members, which
+// are 8-byte aligned like the sections zll1_build lays out
+template <size_t Symbols, size_t Strings, size_t Buckets, size_t Actions, size_t Productions, size_t Rhs>
+struct alignas(8) TableImage {
+    ZLL1Header header;
+    alignas(8) ZLL1Symbol symbols[Symbols];
+    alignas(8) char strings[Strings];
+    alignas(8) int32_t hash[Buckets];
+    alignas(8) int32_t actions[Actions];
+    alignas(8) ZLL1Production productions[Productions];
+    alignas(8) int32_t rhs[Rhs];
+};
+
+// Lay out the analysis exactly like zll1_build
+template <typename Image>
+constexpr Image buildImage(std::string_view source, const Summary& s) {
+    Image image{};
+    if (!s.ok) return image;            // already reported by the static_assert
+    Analysis a = analyze(source);
+    ZLL1Header& h = image.header;
+    h.magic = ZLL1_MAGIC;
+    h.version = ZLL1_VERSION;
+    h.num_symbols = (uint32_t)s.symbols;
+    h.num_terminals = (uint32_t)s.terminals;
+    h.num_productions = (uint32_t)s.productions;
+    h.start_symbol = a.start;
+    h.hash_buckets = (uint32_t)s.buckets;
+    h.file_size = sizeof(Image);
+    h.symbols_offset = offsetof(Image, symbols);
+    h.strings_offset = offsetof(Image, strings);
+    h.strings_size = s.strings;
+    h.hash_offset = offsetof(Image, hash);
+    h.actions_offset = offsetof(Image, actions);
+    h.productions_offset = offsetof(Image, productions);
+    h.rhs_offset = offsetof(Image, rhs);
+    h.rhs_count = s.rhs;
+
+    size_t strings = 0;
+    auto addString = [&](const Text& str) {
+        uint32_t offset = (uint32_t)strings;
+        for (char c : str) image.strings[strings++] = c;
+        image.strings[strings++] = '\0';
+        return offset;
+    };
+    for (size_t id = 0; id < a.names.size(); ++id) {
+        image.symbols[id].name_length = (uint32_t)a.names[id].size();
+        image.symbols[id].name_offset = addString(a.names[id]);
+    }
+    size_t rhs = 0;
+    for (size_t p = 0; p < a.productions.size(); ++p) {
+        const Production& prod = a.productions[p];
+        image.productions[p].lhs = prod.lhs;
+        image.productions[p].rhs_offset = (uint32_t)rhs;
+        image.productions[p].rhs_length = (uint32_t)prod.rhs.size();
+        image.productions[p].text_offset = addString(productionText(view(prod.prodStr)));
+        for (size_t i = prod.rhs.size(); i-- > 0;) image.rhs[rhs++] = prod.rhs[i];
+    }
+
+    for (size_t b = 0; b < s.buckets; ++b) image.hash[b] = -1;
+    for (size_t id = 0; id < a.names.size(); ++id) {
+        uint32_t b = zll1_hash(a.names[id].data(), a.names[id].size()) & (uint32_t)(s.buckets - 1);
+        while (image.hash[b] >= 0) b = (b + 1) & (uint32_t)(s.buckets - 1);
+        image.hash[b] = (int32_t)id;
+    }
+    for (size_t i = 0; i < a.actions.size(); ++i) image.actions[i] = a.actions[i];
+    return image;
+}
+
+} // namespace detail
+
+// LL(1) table of a grammar literal, built at compile time
+template <FixedString Source>
+struct ConstexprGrammar {
+    static constexpr detail::Summary summary = detail::summarize(Source.view());
+    static_assert(std::conditional_t<summary.ok, std::true_type, GrammarError<summary.message>>::value,
+                  "grammar literal is not LL(1) or is malformed");
+
+    using Image = detail::TableImage<detail::atLeastOne(summary.symbols), detail::atLeastOne(summary.strings),
+                                     detail::atLeastOne(summary.buckets), detail::atLeastOne(summary.actions),
+                                     detail::atLeastOne(summary.productions), detail::atLeastOne(summary.rhs)>;
+    static constexpr Image image = detail::buildImage<Image>(Source.view(), summary);
+
+    static const ZLL1Header* header() { return &image.header; }
+    static constexpr size_t size() { return sizeof(Image); }
+};
+
+} // namespace zeta
+
+#endif // ZETA_CONSTEXPR_GRAMMAR_H
@@ -0,0 +1,1872 @@
+//
+// Context-free grammar analysis used by Parser.cpp: left factoring, left recursion
+// elimination, FIRST/FOLLOW sets and the LL(1) parsing table, and incremental production edits.
+//
+#ifndef ZETA_GRAMMAR_H
+#define ZETA_GRAMMAR_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <cstdint>
+#include "ParseTableFormat.h"
+#include "GrammarIR.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+// Bitset helpers working on rows of 64-bit words
+inline bool testBit(const uint64_t* bits, int bit) {
+    return (bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+// sets a bit and reports whether it was newly added
+inline bool setBit(uint64_t* bits, int bit) {
+    uint64_t mask = uint64_t(1) << (bit & 63);
+    bool added = (bits[bit >> 6] & mask) == 0;
+    bits[bit >> 6] |= mask;
+    return added;
+}
+
+// dst |= src over a whole row, with firstWordMask applied to src's first word.
+// Returns true if dst gained any bit.
+inline bool unionBits(uint64_t* dst, const uint64_t* src, size_t words, uint64_t firstWordMask = ~uint64_t(0)) {
+    if (words == 0) return false;
+
+    uint64_t head = src[0] & firstWordMask;
+    bool changed = (head & ~dst[0]) != 0;
+    dst[0] |= head;
+
+    size_t i = 1;
+#if defined(__AVX2__)
+    // four words per step; testc is true when src is already a subset of dst
+    for (; i + 4 <= words; i += 4) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        changed |= !_mm256_testc_si256(d, s);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(d, s));
+    }
+#endif
+    // remaining words (plain loop, auto-vectorized when AVX2 is not enabled)
+    uint64_t added = 0;
+    for (; i < words; ++i) {
+        added |= src[i] & ~dst[i];
+        dst[i] |= src[i];
+    }
+    return changed || added != 0;
+}
+
+// Fixed-width bitsets stored contiguously, one row per non-terminal
+class BitMatrix {
+public:
+    void reset(size_t rows, size_t bits) {
+        rowCount = rows;
+        wordCount = (bits + 63) / 64;
+        data.assign(rowCount * wordCount, 0);
+    }
+
+    uint64_t* row(size_t r) { return data.data() + r * wordCount; }
+    const uint64_t* row(size_t r) const { return data.data() + r * wordCount; }
+
+    size_t rows() const { return rowCount; }
+    size_t words() const { return wordCount; }
+    bool empty() const { return rowCount == 0; }
+
+    void clear() {
+        rowCount = wordCount = 0;
+        data.clear();
+    }
+
+private:
+    size_t rowCount = 0;
+    size_t wordCount = 0;
+    vector<uint64_t> data;
+};
+
+// Strongly connected components of a dependency graph (iterative Tarjan).
+// deps[v] lists the nodes v depends on; components are returned dependencies-first,
+// so every component only depends on itself and on components listed before it.
+inline vector<vector<int>> stronglyConnectedComponents(const vector<vector<int>>& deps) {
+    const int n = (int)deps.size();
+    vector<int> index(n, -1), low(n, 0);
+    vector<char> onStack(n, 0);
+    vector<int> sccStack;
+    vector<pair<int, size_t>> callStack; // (node, next edge to visit)
+    vector<vector<int>> components;
+    int counter = 0;
+
+    for (int root = 0; root < n; ++root) {
+        if (index[root] != -1) continue;
+
+        index[root] = low[root] = counter++;
+        sccStack.push_back(root);
+        onStack[root] = 1;
+        callStack.emplace_back(root, 0);
+
+        while (!callStack.empty()) {
+            int v = callStack.back().first;
+            size_t& next = callStack.back().second;
+
+            if (next < deps[v].size()) {
+                int w = deps[v][next++];
+                if (index[w] == -1) {
+                    // descend into w
+                    index[w] = low[w] = counter++;
+                    sccStack.push_back(w);
+                    onStack[w] = 1;
+                    callStack.emplace_back(w, 0);
+                } else if (onStack[w]) {
+                    low[v] = min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            // all edges of v visited: close its component if v is the root of one
+            if (low[v] == index[v]) {
+                vector<int> component;
+                int w;
+                do {
+                    w = sccStack.back();
+                    sccStack.pop_back();
+                    onStack[w] = 0;
+                    component.push_back(w);
+                } while (w != v);
+                components.push_back(std::move(component));
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int parent = callStack.back().first;
+                low[parent] = min(low[parent], low[v]);
+            }
+        }
+    }
+
+    return components;
+}
+
+// Counters describing how much work a FIRST/FOLLOW solver did
+struct SolverStats {
+    size_t steps = 0;       // operations on the rows being solved: bit insertions, unions and copies
+    size_t edges = 0;       // distinct inclusion edges between non-terminals
+    size_t components = 0;  // strongly connected components (SCC solver only)
+    size_t passes = 0;      // whole-grammar passes (sweep solver only)
+};
+
+// What Grammar::inlineRules changed
+struct InliningReport {
+    vector<string> inlined;         // single-alternative non-terminals replaced by their body
+    size_t unitsCollapsed = 0;      // A -> B alternatives replaced by the alternatives of B
+    size_t unitsKept = 0;           // ... left alone because A would stop being LL(1)
+    vector<string> removed;         // non-terminals no longer used afterwards
+};
+
+// One row of the parsing table: its filled cells as (terminal, production number), in terminal
+// order. The table of a large grammar is almost all empty cells, so only these are kept.
+typedef vector<pair<int, int>> TableRow;
+
+// A parsing table cell claimed by more than one production
+struct TableConflict {
+    vector<string> productions;     // right-hand sides in the order they claimed the cell; the table keeps the last
+    bool fromFollow = false;        // the last claim came through FOLLOW (an ε-production)
+};
+
+// What one incremental edit (Grammar::addProduction, removeProduction, replaceProduction) recomputed
+struct GrammarEdit {
+    bool incremental = true;        // false if the edit changed the symbol set and everything was recomputed
+    size_t firstRows = 0;           // FIRST sets recomputed
+    size_t followRows = 0;          // FOLLOW sets recomputed
+    size_t tableRows = 0;           // parsing table rows refilled
+    vector<pair<string, string>> newConflicts;      // (non-terminal, terminal) cells that became conflicts
+    vector<pair<string, string>> resolvedConflicts; // ... that stopped being conflicts
+};
+
+// Function to print what an incremental edit recomputed and how the conflicts changed
+inline void printGrammarEdit(ostream& out, const GrammarEdit& edit) {
+    out << (edit.incremental ? "Recomputed " : "Recomputed everything (new or unused symbols): ") << edit.firstRows
+        << " FIRST sets, " << edit.followRows << " FOLLOW sets, " << edit.tableRows << " table rows" << endl;
+    for (const auto& cell : edit.newConflicts) out << "  New LL(1) conflict at Table[" << cell.first << ", " << cell.second << "]" << endl;
+    for (const auto& cell : edit.resolvedConflicts) out << "  Resolved LL(1) conflict at Table[" << cell.first << ", " << cell.second << "]" << endl;
+}
+
+// Function to print what Grammar::inlineRules changed
+inline void printInlining(ostream& out, const InliningReport& report) {
+    out << "Single-alternative non-terminals inlined (" << report.inlined.size() << ")";
+    for (size_t i = 0; i < report.inlined.size(); ++i) out << (i ? ", " : ": ") << report.inlined[i];
+    out << endl;
+    out << "Unit alternatives collapsed: " << report.unitsCollapsed << " (" << report.unitsKept
+        << " kept to stay LL(1))" << endl;
+    out << "Non-terminals no longer used (" << report.removed.size() << ")";
+    for (size_t i = 0; i < report.removed.size(); ++i) out << (i ? ", " : ": ") << report.removed[i];
+    out << endl;
+}
+
+// Solve sets[v] ⊇ sets[d] for every edge d in deps[v], starting from the direct contents of sets.
+// Every member of a cycle ends up with the same set, so each SCC is solved by accumulating its
+// members and external dependencies into one row and copying it back: a single visit per edge
+// instead of a worklist iterating inside the component.
+inline void solveInclusions(const vector<vector<int>>& deps, BitMatrix& sets, SolverStats& stats) {
+    const size_t words = sets.words();
+    vector<vector<int>> components = stronglyConnectedComponents(deps);
+    vector<int> componentOf(deps.size());
+    for (size_t c = 0; c < components.size(); ++c) {
+        for (int v : components[c]) componentOf[v] = (int)c;
+    }
+
+    stats.components = components.size();
+    for (const auto& adjacency : deps) stats.edges += adjacency.size();
+
+    for (size_t c = 0; c < components.size(); ++c) {
+        const vector<int>& members = components[c];
+        uint64_t* acc = sets.row(members[0]);
+
+        for (size_t m = 1; m < members.size(); ++m) {
+            unionBits(acc, sets.row(members[m]), words);
+            stats.steps++;
+        }
+        // dependencies in earlier components are already final
+        for (int v : members) {
+            for (int d : deps[v]) {
+                if (componentOf[d] == (int)c) continue;
+                unionBits(acc, sets.row(d), words);
+                stats.steps++;
+            }
+        }
+        for (size_t m = 1; m < members.size(); ++m) {
+            copy(acc, acc + words, sets.row(members[m]));
+            stats.steps++;
+        }
+    }
+}
+
+// Class to store and process Context-Free Grammar (CFG)
+class Grammar {
+public:
+    // The grammar being transformed: symbol names, rules and production bodies
+    GrammarIR ir;
+
+    // Sets of terminals and non-terminals
+    set<string> nonTerminals;
+    set<string> terminals;
+
+    // map to hold the parsing table
+    map<pair<string, string>, string> parsingTable;
+
+    // Reserved IDs: ε and the end marker are the first two terminals
+    static constexpr int EPSILON_ID = 0;
+    static constexpr int END_MARKER_ID = 1;
+
+    // Dense symbol IDs: [0, terminalCount) are terminals, the rest are non-terminals in cfg order
+    SymbolInterner symbols;
+    int terminalCount = 0;
+
+    // Productions of each non-terminal as ID sequences (ε tokens dropped), in name order
+    vector<vector<vector<int>>> idRules;
+
+    // Productions numbered in that order: production p of non-terminal nt is ruleOffsets[nt] + p
+    vector<int> ruleOffsets;
+
+    // Right-hand side text of every production by number ("ε" when empty)
+    vector<string> productionTexts;
+
+    // Start symbol chosen by computeFollow (non-terminal index)
+    int startIndex = -1;
+
+    // Parsing table by IDs: tableRows[nt] holds the filled cells of non-terminal nt's row
+    vector<TableRow> tableRows;
+
+    // Table cells claimed by more than one production, by (non-terminal, terminal)
+    map<pair<string, string>, TableConflict> conflicts;
+
+    // usedBy[symbol] counts, per non-terminal index, the symbol's occurrences in that non-terminal's
+    // productions; built by the first incremental edit and kept up to date by the later ones
+    vector<unordered_map<int, int>> usedBy;
+
+    // Terminal IDs ordered by name, used wherever sets are printed
+    vector<int> terminalsByName;
+
+    // First and follow sets, one bitset over terminal IDs per non-terminal
+    BitMatrix firstSets;
+    BitMatrix followSets;
+
+    // Where reading errors, the start symbol warning, edit errors and conflict reports go
+    // (the C API of ZetaParser.h collects them per grammar instead of printing them)
+    ostream* diagnostics = &cerr;
+
+
+    // Default constructor
+    Grammar() = default;
+
+    // Function to read grammar from a file
+    int readGrammar(const string& fileName) {
+        // File opening validation
+        ifstream file(fileName);
+        if (!file) {
+            *diagnostics << "Error: Could not open file." << endl;
+            return 0;
+        }
+        return readGrammar(file);
+    }
+
+    // Function to read grammar in the cfg.txt format from a stream
+    int readGrammar(istream& file) {
+        string line;
+
+        // Read each line of the file
+        while (getline(file, line)) {
+            // Read one line of the cfg (a production rule) into a string stream
+            istringstream iss(line);
+            string lhs, arrow, rhs;
+
+            // Extract non-terminal on the Left hand side into lhs, and the arrow "->" into arrow
+            iss >> lhs >> arrow;
+
+            // Production format validation
+            if (arrow != "->") {
+                *diagnostics << "Error: Invalid production format." << endl;
+                return 0;
+            }
+
+            // Extract right-hand side (actual productions) into rhs
+            getline(iss, rhs);
+
+            // Read the rhs of the cfg into a string stream
+            istringstream rhsStream(rhs);
+            string production;
+
+            // Split productions by '|' and append each body to the arena
+            int lhsId = ir.symbol(lhs);
+            while (getline(rhsStream, production, '|')) {
+                vector<int> body;
+                for (const string& token : tokenizeProduction(production)) {
+                    // ε inside a sequence derives nothing, so it is simply dropped
+                    if (token != "ε") body.push_back(ir.symbol(token));
+                }
+                IRSpan span = ir.append({0, 0}, body);
+                ir.rules[lhsId].push_back(span);
+            }
+
+        }
+
+        return 1;
+    }
+
+    // Function to print the CFG
+    void printGrammar(ostream& out = cout) {
+        for (int lhs : ir.nonTerminalsByName()) {
+            const vector<IRSpan>& productions = ir.rules[lhs];
+            // Print non-terminal of rule
+            out << ir.names.name(lhs) << " -> ";
+            for (size_t i = 0; i < productions.size(); ++i) {
+                // Print right-hand side productions
+                out << ir.text(productions[i]);
+                // Separate multiple productions
+                if (i < productions.size() - 1) out << " | ";
+            }
+            out << endl;
+        }
+    }
+
+    // Function that applies left factoring to the CFG (see factorLeft in GrammarIR.h)
+    int leftFactoring() { return factorLeft(ir); }
+
+    // Function to remove left recursion in productions (see eliminateLeftRecursion in GrammarIR.h)
+    int leftRecursion() { return eliminateLeftRecursion(ir); }
+
+    // Function to drop non-productive and unreachable symbols and merge identical rules (see reduceGrammar)
+    int reduce(GrammarReduction& report) { return reduceGrammar(ir, report); }
+
+    // Function to shorten expansion chains: every non-terminal with a single alternative (other
+    // than the start symbol) is replaced by its body wherever it is used, and a unit alternative
+    // A -> B is replaced by the alternatives of B when A's alternatives keep disjoint lookaheads.
+    // Inlining a single alternative changes no FIRST set and only narrows FOLLOW sets, so it
+    // cannot add conflicts; unit chains are checked against FIRST/FOLLOW of the grammar as it was.
+    int inlineRules(InliningReport& report) {
+        report = InliningReport();
+        computeFirst();
+        computeFollow();
+        int start = ir.startSymbol();
+        vector<int> analysisId(ir.names.size(), -1);
+        for (int id = 0; id < ir.names.size(); ++id) analysisId[id] = symbols.lookup(ir.names.name(id));
+
+        // single-alternative non-terminals, with their bodies fully expanded
+        vector<int> nonTerminalIds = ir.nonTerminalsByName();
+        vector<char> single(ir.rules.size(), 0);
+        for (int lhs : nonTerminalIds) single[lhs] = lhs != start && ir.rules[lhs].size() == 1;
+
+        // a single alternative that reaches itself through single alternatives (A -> x A, or
+        // A -> x B and B -> y A, which only --no-reduce keeps) has no finite expansion: it is
+        // kept as a rule, or A would be left referenced without one and read as a terminal
+        vector<vector<int>> singleUses(ir.rules.size());
+        for (int lhs : nonTerminalIds) {
+            if (!single[lhs]) continue;
+            const IRSpan& body = ir.rules[lhs][0];
+            for (const int* it = ir.begin(body); it != ir.end(body); ++it) {
+                if (single[*it]) singleUses[lhs].push_back(*it);
+            }
+        }
+        for (const vector<int>& component : stronglyConnectedComponents(singleUses)) {
+            int first = component[0];
+            bool cycle = component.size() > 1 || count(singleUses[first].begin(), singleUses[first].end(), first);
+            if (cycle) for (int lhs : component) single[lhs] = 0;
+        }
+        vector<vector<int>> expansion(ir.rules.size());
+        vector<char> state(ir.rules.size(), 0); // 1: expanding, 2: done
+        function<bool(int)> expand = [&](int lhs) {
+            if (state[lhs] == 2) return true;
+            if (state[lhs] == 1) return false; // a cycle of single alternatives never ends
+            state[lhs] = 1;
+            const IRSpan& body = ir.rules[lhs][0];
+            for (uint32_t i = 0; i < body.length; ++i) {
+                int symbol = ir.arena[body.offset + i];
+                if (single[symbol] && expand(symbol)) {
+                    expansion[lhs].insert(expansion[lhs].end(), expansion[symbol].begin(), expansion[symbol].end());
+                } else {
+                    expansion[lhs].push_back(symbol);
+                }
+            }
+            state[lhs] = 2;
+            return true;
+        };
+        for (int lhs : nonTerminalIds) {
+            if (single[lhs] && !expand(lhs)) single[lhs] = 0;
+        }
+        for (int lhs : nonTerminalIds) {
+            if (single[lhs]) continue;
+            for (IRSpan& span : ir.rules[lhs]) {
+                if (none_of(ir.begin(span), ir.end(span), [&](int symbol) { return single[symbol]; })) continue;
+                vector<int> body;
+                for (uint32_t i = 0; i < span.length; ++i) {
+                    int symbol = ir.arena[span.offset + i];
+                    if (single[symbol]) body.insert(body.end(), expansion[symbol].begin(), expansion[symbol].end());
+                    else body.push_back(symbol);
+                }
+                span = ir.append({0, 0}, body);
+            }
+        }
+        for (int lhs : nonTerminalIds) {
+            if (!single[lhs]) continue;
+            report.inlined.push_back(ir.names.name(lhs));
+            ir.rules[lhs].clear();
+        }
+
+        // unit alternatives, following chains A -> B -> C while the lookaheads stay disjoint
+        vector<uint64_t> firstSet(firstSets.words());
+        for (int lhs : ir.nonTerminalsByName()) {
+            vector<IRSpan> alternatives = ir.rules[lhs];
+            set<int> tried = {lhs};
+            for (size_t i = 0; i < alternatives.size(); ++i) {
+                IRSpan unit = alternatives[i];
+                if (unit.length != 1 || !ir.isNonTerminal(ir.arena[unit.offset]) || !tried.insert(ir.arena[unit.offset]).second) continue;
+                const vector<IRSpan>& replacement = ir.rules[ir.arena[unit.offset]];
+                vector<IRSpan> candidate(alternatives.begin(), alternatives.begin() + (long)i);
+                candidate.insert(candidate.end(), replacement.begin(), replacement.end());
+                candidate.insert(candidate.end(), alternatives.begin() + (long)i + 1, alternatives.end());
+                if (!hasDisjointLookaheads(nonTerminalIndex(analysisId[lhs]), candidate, analysisId, firstSet.data())) {
+                    report.unitsKept++;
+                    continue;
+                }
+                alternatives = std::move(candidate);
+                report.unitsCollapsed++;
+                i = (size_t)-1; // the replacement may start with another unit alternative
+            }
+            ir.rules[lhs] = std::move(alternatives);
+        }
+
+        GrammarReduction unused;
+        removeUnreachable(ir, unused);
+        report.removed = unused.unreachable;
+
+        // the analysis above belongs to the grammar before inlining
+        firstSets.clear();
+        followSets.clear();
+        tableRows.clear();
+        return 1;
+    }
+
+    // Function to check that alternatives of a non-terminal select distinct table cells: their
+    // FIRST sets are disjoint, at most one is nullable, and FOLLOW of a nullable one is disjoint
+    // from the FIRST sets of the others
+    bool hasDisjointLookaheads(int nt, const vector<IRSpan>& alternatives, const vector<int>& analysisId, uint64_t* firstSet) const {
+        const size_t words = firstSets.words();
+        vector<uint64_t> seen(words, 0);
+        bool nullable = false;
+        vector<int> ids;
+        for (const IRSpan& span : alternatives) {
+            ids.clear();
+            for (const int* it = ir.begin(span); it != ir.end(span); ++it) ids.push_back(analysisId[*it]);
+            if (firstOfSequence(ids.data(), ids.data() + ids.size(), firstSet)) {
+                if (nullable) return false;
+                nullable = true;
+            }
+            firstSet[0] &= ~(uint64_t(1) << EPSILON_ID);
+            for (size_t w = 0; w < words; ++w) {
+                if (seen[w] & firstSet[w]) return false;
+                seen[w] |= firstSet[w];
+            }
+        }
+        if (!nullable) return true;
+        // seen now holds FIRST of every alternative; only the nullable one may be chosen on FOLLOW
+        for (const IRSpan& span : alternatives) {
+            ids.clear();
+            for (const int* it = ir.begin(span); it != ir.end(span); ++it) ids.push_back(analysisId[*it]);
+            if (firstOfSequence(ids.data(), ids.data() + ids.size(), firstSet)) continue;
+            const uint64_t* follow = followSets.row(nt);
+            for (size_t w = 0; w < words; ++w) {
+                if (firstSet[w] & follow[w]) return false;
+            }
+        }
+        return true;
+    }
+
+    // number of productions over all rules
+    size_t productionCount() const { return ir.size().productions; }
+
+    // identify all terminals and non-terminals in the grammar and store them
+    void initializeSymbols() {
+        nonTerminals.clear();
+        terminals.clear();
+
+        // add all LHS symbols to non-terminal set
+        vector<int> lhsIds = ir.nonTerminalsByName();
+        for (int lhs : lhsIds) {
+            nonTerminals.insert(ir.names.name(lhs));
+        }
+
+        // Find terminals: every other symbol a production uses
+        for (int lhs : lhsIds) {
+            for (const IRSpan& span : ir.rules[lhs]) {
+                for (const int* it = ir.begin(span); it != ir.end(span); ++it) {
+                    if (!ir.isNonTerminal(*it)) { terminals.insert(ir.names.name(*it)); }
+                }
+            }
+        }
+    }
+
+    // assign dense IDs to all symbols and pre-split every production into an ID sequence
+    void internSymbols() {
+        symbols.clear();
+        symbols.intern("ε");
+        symbols.intern("$");
+        for (const string& term : terminals) symbols.intern(term);
+        terminalCount = symbols.size();
+        for (const string& nonTerm : nonTerminals) symbols.intern(nonTerm);
+
+        // IR symbol ID -> analysis ID
+        vector<int> remap(ir.names.size(), -1);
+        for (int id = 0; id < ir.names.size(); ++id) remap[id] = symbols.lookup(ir.names.name(id));
+
+        idRules.clear();
+        usedBy.clear();
+        idRules.reserve(nonTerminals.size());
+        ruleOffsets.clear();
+        productionTexts.clear();
+        int productionCount = 0;
+        for (int lhs : ir.nonTerminalsByName()) {
+            const vector<IRSpan>& productions = ir.rules[lhs];
+            ruleOffsets.push_back(productionCount);
+            productionCount += (int)productions.size();
+            vector<vector<int>> prods;
+            prods.reserve(productions.size());
+            for (const IRSpan& span : productions) {
+                vector<int> ids;
+                ids.reserve(span.length);
+                for (const int* it = ir.begin(span); it != ir.end(span); ++it) ids.push_back(remap[*it]);
+                prods.push_back(std::move(ids));
+                productionTexts.push_back(ir.text(span));
+            }
+            idRules.push_back(std::move(prods));
+        }
+
+        terminalsByName.resize(terminalCount);
+        for (int id = 0; id < terminalCount; ++id) terminalsByName[id] = id;
+        sort(terminalsByName.begin(), terminalsByName.end(),
+             [this](int a, int b) { return symbols.name(a) < symbols.name(b); });
+    }
+
+    bool isTerminal(int id) const { return id < terminalCount; }
+    int nonTerminalIndex(int id) const { return id - terminalCount; }
+
+    // members of a terminal bitset, in name order
+    vector<int> sortedMembers(const uint64_t* bits) const {
+        vector<int> members;
+        for (int id : terminalsByName) {
+            if (testBit(bits, id)) members.push_back(id);
+        }
+        return members;
+    }
+
+    // Statistics of the last FIRST/FOLLOW computations
+    SolverStats firstStats;
+    SolverStats followStats;
+
+    // nullable[nt] is true if the non-terminal derives ε (linear worklist over production counters)
+    vector<char> computeNullable() const {
+        const size_t nonTermCount = idRules.size();
+        vector<char> nullable(nonTermCount, 0);
+        vector<int> worklist;
+
+        // pending[p] = non-terminal occurrences of production p not yet known to be nullable
+        vector<int> pending;
+        vector<int> owner;
+        vector<vector<int>> usedIn(nonTermCount);
+
+        for (size_t nt = 0; nt < nonTermCount; ++nt) {
+            for (const vector<int>& prod : idRules[nt]) {
+                bool hasTerminal = any_of(prod.begin(), prod.end(), [this](int s) { return isTerminal(s); });
+                if (hasTerminal) continue; // can never derive ε
+
+                int p = (int)pending.size();
+                pending.push_back((int)prod.size());
+                owner.push_back((int)nt);
+                for (int symbol : prod) usedIn[nonTerminalIndex(symbol)].push_back(p);
+
+                if (prod.empty() && !nullable[nt]) {
+                    nullable[nt] = 1;
+                    worklist.push_back((int)nt);
+                }
+            }
+        }
+
+        while (!worklist.empty()) {
+            int nt = worklist.back();
+            worklist.pop_back();
+            for (int p : usedIn[nt]) {
+                if (--pending[p] == 0 && !nullable[owner[p]]) {
+                    nullable[owner[p]] = 1;
+                    worklist.push_back(owner[p]);
+                }
+            }
+        }
+        return nullable;
+    }
+
+    // function to make FIRST set for all non-terminals
+    // Builds the "FIRST(A) includes FIRST(B)" graph once and solves it SCC by SCC.
+    int computeFirst() {
+        initializeSymbols();
+        internSymbols();
+
+        const size_t nonTermCount = idRules.size();
+        firstSets.reset(nonTermCount, terminalCount);
+        followSets.clear();
+        firstStats = SolverStats();
+
+        vector<char> nullable = computeNullable();
+
+        // direct terminals go straight into the sets, non-terminals become edges
+        vector<vector<int>> deps(nonTermCount);
+        for (size_t nt = 0; nt < nonTermCount; ++nt) {
+            uint64_t* lhsFirst = firstSets.row(nt);
+            for (const vector<int>& prod : idRules[nt]) {
+                for (int symbol : prod) {
+                    if (isTerminal(symbol)) {
+                        setBit(lhsFirst, symbol);
+                        firstStats.steps++;
+                        break;
+                    }
+                    int dep = nonTerminalIndex(symbol);
+                    if (dep != (int)nt) deps[nt].push_back(dep);
+                    if (!nullable[dep]) break;
+                }
+            }
+            sort(deps[nt].begin(), deps[nt].end());
+            deps[nt].erase(unique(deps[nt].begin(), deps[nt].end()), deps[nt].end());
+        }
+
+        solveInclusions(deps, firstSets, firstStats);
+
+        // ε is per symbol, not shared across a cycle, so it is added after propagation
+        for (size_t nt = 0; nt < nonTermCount; ++nt) {
+            if (nullable[nt]) {
+                setBit(firstSets.row(nt), EPSILON_ID);
+                firstStats.steps++;
+            }
+        }
+
+        return 1;
+    }
+
+    // Reference FIRST computation: repeated sweeps over the whole grammar until nothing changes.
+    // Produces the same sets as computeFirst; kept to measure the solver against.
+    int computeFirstBySweep() {
+        initializeSymbols();
+        internSymbols();
+
+        // Initialize first sets (terminals are handled directly, FIRST(a) = {a})
+        firstSets.reset(nonTerminals.size(), terminalCount);
+        followSets.clear();
+        firstStats = SolverStats();
+        const size_t words = firstSets.words();
+        const uint64_t withoutEpsilon = ~(uint64_t(1) << EPSILON_ID);
+
+        bool changed = true;
+        // iterate until no changes in an iteration
+        while (changed) {
+            changed = false;
+            firstStats.passes++;
+
+            // iterate over the cfg
+            for (size_t nt = 0; nt < idRules.size(); ++nt) {
+                uint64_t* lhsFirst = firstSets.row(nt);
+
+                // compute First for each production X -> Y1 Y2 ... Yk (X -> ε is the empty sequence)
+                for (const vector<int>& prod : idRules[nt]) {
+                    // flag to track if all symbols in production can derive ε
+                    bool allDeriveEpsilon = true;
+
+                    for (int symbol : prod) {
+                        firstStats.steps++;
+
+                        // a terminal ends the production's contribution
+                        if (isTerminal(symbol)) {
+                            if (setBit(lhsFirst, symbol)) changed = true;
+                            allDeriveEpsilon = false;
+                            break;
+                        }
+
+                        // Add all elements from First(symbol) except epsilon to First(lhs)
+                        const uint64_t* symbolFirst = firstSets.row(nonTerminalIndex(symbol));
+                        if (unionBits(lhsFirst, symbolFirst, words, withoutEpsilon)) changed = true;
+
+                        // if this symbol cannot derive epsilon, stop processing more symbols
+                        if (!testBit(symbolFirst, EPSILON_ID)) {
+                            allDeriveEpsilon = false;
+                            break;
+                        }
+                    }
+
+                    // If all symbols of the production can derive epsilon, add epsilon to First(lhs)
+                    if (allDeriveEpsilon) {
+                        if (setBit(lhsFirst, EPSILON_ID)) changed = true;
+                        firstStats.steps++;
+                    }
+                }
+            }
+        }
+
+        return 1;
+    }
+
+
+    // Helper function to compute First of a sequence of symbol IDs (production RHS)
+    // Returns true if the sequence can derive epsilon, false otherwise.
+    // Overwrites firstSet with the First set of the sequence (ε bit included when nullable).
+    bool firstOfSequence(const int* begin, const int* end, uint64_t* firstSet) const {
+        const size_t words = firstSets.words();
+        const uint64_t withoutEpsilon = ~(uint64_t(1) << EPSILON_ID);
+        fill(firstSet, firstSet + words, 0);
+
+        for (const int* it = begin; it != end; ++it) {
+            if (isTerminal(*it)) {
+                setBit(firstSet, *it);
+                return false;
+            }
+
+            const uint64_t* symbolFirst = firstSets.row(nonTerminalIndex(*it));
+            unionBits(firstSet, symbolFirst, words, withoutEpsilon);
+
+            // Stop if a symbol doesn't derive epsilon
+            if (!testBit(symbolFirst, EPSILON_ID)) return false;
+        }
+
+        // If all symbols derived epsilon, add epsilon to the result set
+        setBit(firstSet, EPSILON_ID);
+        return true;
+    }
+
+    // Rule 1 of FOLLOW: index of the start symbol that receives $, or -1 if there is none
+    int startSymbolIndex() {
+        // *** MODIFIED: Explicitly use "P" as the start symbol for this grammar ***
+        string startSymbol = "P";
+        if (!nonTerminals.count(startSymbol)) { // Check if P exists
+             // Fallback or error if P is not found (should not happen with the given grammar)
+             string firstKey = nonTerminals.empty() ? "" : *nonTerminals.begin();
+             if (firstKey.empty()) {
+                 *diagnostics << "Error: Cannot determine start symbol." << endl;
+                 return -1; // Cannot proceed without a start symbol
+             }
+             *diagnostics << "Warning: Explicit start symbol 'P' not found. Using first rule's LHS: '" << firstKey << "' as start symbol." << endl;
+             startSymbol = firstKey;
+        }
+        return nonTerminalIndex(symbols.lookup(startSymbol));
+    }
+
+    // function to make FOLLOW set for all non-terminals
+    // Each production is scanned once, right to left: FIRST of the remaining suffix is added to
+    // FOLLOW(B) directly, and a nullable suffix becomes the edge "FOLLOW(B) includes FOLLOW(A)".
+    int computeFollow() {
+
+        // Ensure FIRST sets (and symbol IDs) are computed
+        if (firstSets.empty()) {
+            computeFirst();
+        }
+
+        const size_t nonTermCount = idRules.size();
+        followSets.reset(nonTermCount, terminalCount);
+        followStats = SolverStats();
+        const size_t words = followSets.words();
+        const uint64_t withoutEpsilon = ~(uint64_t(1) << EPSILON_ID);
+
+        startIndex = startSymbolIndex();
+        if (startIndex < 0) return 0;
+        setBit(followSets.row(startIndex), END_MARKER_ID);
+
+        vector<vector<int>> deps(nonTermCount);
+        vector<uint64_t> suffixFirst(words);
+
+        for (size_t nt_A = 0; nt_A < nonTermCount; ++nt_A) {
+            for (const vector<int>& prod : idRules[nt_A]) {
+                fill(suffixFirst.begin(), suffixFirst.end(), 0);
+                bool suffixNullable = true;
+
+                for (size_t i = prod.size(); i-- > 0;) {
+                    int symbol = prod[i];
+                    if (isTerminal(symbol)) {
+                        fill(suffixFirst.begin(), suffixFirst.end(), 0);
+                        setBit(suffixFirst.data(), symbol);
+                        suffixNullable = false;
+                        continue;
+                    }
+
+                    int nt_B = nonTerminalIndex(symbol);
+                    unionBits(followSets.row(nt_B), suffixFirst.data(), words);
+                    followStats.steps++;
+                    if (suffixNullable && nt_B != (int)nt_A) deps[nt_B].push_back((int)nt_A);
+
+                    // extend the suffix with B
+                    const uint64_t* first_B = firstSets.row(nt_B);
+                    if (testBit(first_B, EPSILON_ID)) {
+                        unionBits(suffixFirst.data(), first_B, words, withoutEpsilon);
+                    } else {
+                        copy(first_B, first_B + words, suffixFirst.begin());
+                        suffixFirst[0] &= withoutEpsilon;
+                        suffixNullable = false;
+                    }
+                }
+            }
+        }
+
+        for (auto& adjacency : deps) {
+            sort(adjacency.begin(), adjacency.end());
+            adjacency.erase(unique(adjacency.begin(), adjacency.end()), adjacency.end());
+        }
+        solveInclusions(deps, followSets, followStats);
+
+        return 1;
+    }
+
+    // Reference FOLLOW computation by whole-grammar sweeps, counterpart of computeFirstBySweep
+    int computeFollowBySweep() {
+
+        // Ensure FIRST sets (and symbol IDs) are computed
+        if (firstSets.empty()) {
+            computeFirstBySweep();
+        }
+
+
+        // initialize Follow sets
+        followSets.reset(nonTerminals.size(), terminalCount);
+        followStats = SolverStats();
+        const size_t words = followSets.words();
+        const uint64_t withoutEpsilon = ~(uint64_t(1) << EPSILON_ID);
+
+        // Rule 1: Add $ to Follow of the designated start symbol
+        startIndex = startSymbolIndex();
+        if (startIndex < 0) return 0;
+        setBit(followSets.row(startIndex), END_MARKER_ID);
+
+        vector<uint64_t> firstOfBeta(words);
+
+        bool changed = true;
+        // iterate until no changes in an iteration
+        while (changed) {
+            changed = false;
+            followStats.passes++;
+
+            // Iterate over rules in the CFG: A -> α
+            for (size_t nt_A = 0; nt_A < idRules.size(); ++nt_A) {
+                for (const vector<int>& prod : idRules[nt_A]) {
+
+                    // Iterate over each symbol B in the production α
+                    for (size_t i = 0; i < prod.size(); ++i) {
+                        // We only compute Follow for non-terminals
+                        if (isTerminal(prod[i])) continue;
+                        uint64_t* follow_B = followSets.row(nonTerminalIndex(prod[i]));
+
+                        // Rule 2: A -> α B β
+                        // Add First(β) - {ε} to Follow(B), where β is the rest of the production
+                        bool betaDerivesEpsilon = firstOfSequence(prod.data() + i + 1, prod.data() + prod.size(), firstOfBeta.data());
+                        if (unionBits(follow_B, firstOfBeta.data(), words, withoutEpsilon)) changed = true;
+                        followStats.steps++;
+
+                        // Rule 3: A -> α B or A -> α B β where First(β) contains ε
+                        // Add Follow(A) to Follow(B)
+                        if (betaDerivesEpsilon) {
+                            if (unionBits(follow_B, followSets.row(nt_A), words)) changed = true;
+                            followStats.steps++;
+                        }
+                    }
+                }
+            }
+        }
+
+        return 1;
+    }
+
+    // function to print First and Follow sets
+    void printFirstAndFollow() {
+        cout << "\nFirst Sets:" << endl;
+        // iterate over all non-terminals and print items of each non-terminal's first set
+        // (nonTerminals is already sorted, and sortedMembers keeps terminals in name order)
+        for (const auto& nonTerm : nonTerminals) {
+            cout << "First(" << left << setw(max(10, (int)nonTerm.length())) << nonTerm << ") = { ";
+            string sep = "";
+            for (int term : sortedMembers(firstSets.row(nonTerminalIndex(symbols.lookup(nonTerm))))) {
+                 cout << sep << symbols.name(term);
+                 sep = ", ";
+            }
+            cout << " }" << endl;
+        }
+
+
+        cout << "\nFollow Sets:" << endl;
+        // iterate over all non-terminals and print items of each non-terminal's follow set
+        for (const auto& nonTerm : nonTerminals) {
+            cout << "Follow(" << left << setw(max(10, (int)nonTerm.length())) << nonTerm << ") = { ";
+            string sep = "";
+            for (int term : sortedMembers(followSets.row(nonTerminalIndex(symbols.lookup(nonTerm))))) {
+                cout << sep << symbols.name(term);
+                sep = ", ";
+            }
+            cout << " }" << endl;
+        }
+    }
+
+    // print a conflicting cell together with the sets that produced it
+    void reportConflict(const string& nonTerm_A, const string& term, const string& prodStr,
+                        const uint64_t* firstOfAlpha, bool fromFollow) {
+        const uint64_t* follow_A = followSets.row(nonTerminalIndex(symbols.lookup(nonTerm_A)));
+        pair<string, string> tableKey = make_pair(nonTerm_A, term);
+
+        *diagnostics << (fromFollow ? "\nLL(1) Conflict Detected (Epsilon Rule)!" : "\nLL(1) Conflict Detected!") << endl;
+        *diagnostics << "  At Table[" << nonTerm_A << ", " << term << "]:" << endl;
+        *diagnostics << "  Existing production: " << nonTerm_A << " -> " << parsingTable[tableKey] << endl;
+        *diagnostics << "  New production:      " << nonTerm_A << " -> " << prodStr << (fromFollow ? " (due to FOLLOW set)" : "") << endl;
+        *diagnostics << "  FIRST(" << prodStr << ") = {";
+        for (int f : sortedMembers(firstOfAlpha)) *diagnostics << symbols.name(f) << ",";
+        *diagnostics << "}" << endl;
+        *diagnostics << "  FOLLOW(" << nonTerm_A << ") = {";
+        for (int f : sortedMembers(follow_A)) *diagnostics << symbols.name(f) << ",";
+        *diagnostics << "}" << endl;
+    }
+
+    // Function to fill the table row of non-terminal nt_A (its cells must be empty), recording
+    // conflicting cells; verbose prints every conflict with the sets that produced it
+    void fillTableRow(size_t nt_A, uint64_t* firstOfAlpha, bool verbose) {
+        const string& nonTerm_A = symbols.name(terminalCount + (int)nt_A);
+        const uint64_t* follow_A = followSets.row(nt_A);
+        TableRow& row = tableRows[nt_A];
+
+        for (size_t p = 0; p < idRules[nt_A].size(); ++p) { // α
+            const string& prodStr = productionTexts[ruleOffsets[nt_A] + p];
+            const vector<int>& prod_alpha = idRules[nt_A][p];
+
+            // Compute FIRST(α)
+            bool alphaDerivesEpsilon = firstOfSequence(prod_alpha.data(), prod_alpha.data() + prod_alpha.size(), firstOfAlpha);
+
+            // Rule 1: For each terminal 'a' in FIRST(α), add A -> α to M[A, a]
+            // Rule 2: If ε is in FIRST(α), then for each terminal 'b' in FOLLOW(A), add A -> α to M[A, b]
+            for (int pass = 0; pass < 2; ++pass) {
+                bool fromFollow = pass == 1;
+                if (fromFollow && !alphaDerivesEpsilon) break;
+                const uint64_t* lookaheads = fromFollow ? follow_A : firstOfAlpha;
+
+                for (int term : sortedMembers(lookaheads)) {
+                    if (term == EPSILON_ID) continue;
+                    pair<string, string> tableKey = make_pair(nonTerm_A, symbols.name(term));
+
+                    // Check for conflicts (non-LL(1) grammar)
+                    auto existing = parsingTable.find(tableKey);
+                    if (existing != parsingTable.end() && existing->second != prodStr) {
+                        TableConflict& conflict = conflicts[tableKey];
+                        if (conflict.productions.empty()) conflict.productions.push_back(existing->second);
+                        conflict.productions.push_back(prodStr);
+                        conflict.fromFollow = fromFollow;
+                        if (verbose) reportConflict(nonTerm_A, tableKey.second, prodStr, firstOfAlpha, fromFollow);
+                    }
+
+                    // Add the original string production to the parsing table
+                    parsingTable[tableKey] = prodStr;
+                    row.emplace_back(term, ruleOffsets[nt_A] + (int)p);
+                }
+            }
+        }
+
+        // in terminal order; a cell claimed more than once keeps the last production, as above
+        stable_sort(row.begin(), row.end(), [](const pair<int, int>& a, const pair<int, int>& b) { return a.first < b.first; });
+        size_t kept = 0;
+        for (const pair<int, int>& cell : row) {
+            if (kept > 0 && row[kept - 1].first == cell.first) row[kept - 1] = cell;
+            else row[kept++] = cell;
+        }
+        row.resize(kept);
+    }
+
+    // Function to count the filled cells of the table
+    size_t tableCellCount() const {
+        size_t cells = 0;
+        for (const TableRow& row : tableRows) cells += row.size();
+        return cells;
+    }
+
+    int computeParsingTable(bool verbose = true) {
+        // Make sure First and Follow sets are computed
+        if (firstSets.empty()) computeFirst();
+        if (followSets.empty()) computeFollow();
+
+
+        // Clear the existing parsing table
+        parsingTable.clear();
+        tableRows.assign(idRules.size(), TableRow());
+        conflicts.clear();
+
+        // Add $ as a terminal for end of input if not already present
+        terminals.insert("$");
+
+        // Iterative over rules in the cfg: A -> α
+        vector<uint64_t> firstOfAlpha(firstSets.words());
+        for (size_t nt_A = 0; nt_A < idRules.size(); ++nt_A) fillTableRow(nt_A, firstOfAlpha.data(), verbose);
+
+        return 1; // Indicate success (though conflicts might have been printed)
+    }
+
+    // Incremental edits of the analysed grammar. Each one changes a production of the grammar as
+    // transformed (nothing is factored or eliminated again, so conflicts it introduces are
+    // reported, not fixed) and brings the sets and the table up to date by recomputing only
+    // what can depend on the edited non-terminal A:
+    //   FIRST   the non-terminals reaching A through a nullable prefix (found through usedBy)
+    //   FOLLOW  symbols in front of a changed FIRST set or in the edited productions, and the
+    //           non-terminals inheriting FOLLOW from them through a nullable tail
+    //   table   the rows of A, of the users of a changed FIRST set and of a changed FOLLOW set
+    // An edit that adds a symbol or drops the last use of a terminal changes the symbol IDs and
+    // falls back to the full computation. Productions numbered after the edited one are shifted
+    // in place (ruleOffsets, productionTexts and the table cells referring to them).
+
+    // Function to add lhs -> rhs (rhs written as in the grammar file, "ε" for an empty production)
+    int addProduction(const string& lhs, const string& rhs, GrammarEdit& edit) {
+        return editProduction(lhs, nullptr, &rhs, edit);
+    }
+
+    // Function to remove the production lhs -> rhs
+    int removeProduction(const string& lhs, const string& rhs, GrammarEdit& edit) {
+        return editProduction(lhs, &rhs, nullptr, edit);
+    }
+
+    // Function to replace lhs -> oldRhs by lhs -> newRhs, keeping its place among lhs's productions
+    int replaceProduction(const string& lhs, const string& oldRhs, const string& newRhs, GrammarEdit& edit) {
+        return editProduction(lhs, &oldRhs, &newRhs, edit);
+    }
+
+    // usedBy from scratch
+    void buildUsedBy() {
+        usedBy.assign(symbols.size(), {});
+        for (size_t nt = 0; nt < idRules.size(); ++nt) {
+            for (const vector<int>& prod : idRules[nt]) countUses((int)nt, prod, 1);
+        }
+    }
+
+    void countUses(int nt, const vector<int>& prod, int delta) {
+        for (int symbol : prod) {
+            int& uses = usedBy[symbol][nt];
+            uses += delta;
+            if (uses == 0) usedBy[symbol].erase(nt);
+        }
+    }
+
+    // Function behind the three edits: removes oldRhs (if set) and adds newRhs (if set) in its place
+    int editProduction(const string& lhs, const string* oldRhs, const string* newRhs, GrammarEdit& edit) {
+        edit = GrammarEdit();
+        vector<string> oldBody, newBody;
+        for (const string& token : tokenizeProduction(oldRhs ? *oldRhs : "")) if (token != "ε") oldBody.push_back(token);
+        for (const string& token : tokenizeProduction(newRhs ? *newRhs : "")) if (token != "ε") newBody.push_back(token);
+        const string oldText = oldBody.empty() ? "ε" : joinTokens(oldBody);
+        const string newText = newBody.empty() ? "ε" : joinTokens(newBody);
+
+        // find the production to remove, and make sure the one to add is not there already
+        int lhsIr = ir.names.lookup(lhs);
+        int alternative = -1;
+        if (ir.isNonTerminal(lhsIr)) {
+            const vector<IRSpan>& alternatives = ir.rules[lhsIr];
+            for (size_t a = 0; a < alternatives.size() && oldRhs && alternative < 0; ++a) {
+                if (ir.text(alternatives[a]) == oldText) alternative = (int)a;
+            }
+            for (size_t a = 0; a < alternatives.size() && newRhs; ++a) {
+                if ((int)a != alternative && ir.text(alternatives[a]) == newText) {
+                    *diagnostics << "Error: Production " << lhs << " -> " << newText << " already exists." << endl;
+                    return 0;
+                }
+            }
+        }
+        if (count(newBody.begin(), newBody.end(), "|") || count(oldBody.begin(), oldBody.end(), "|")) {
+            *diagnostics << "Error: An edit names a single production, without '|'." << endl;
+            return 0;
+        }
+        if (oldRhs && alternative < 0) {
+            *diagnostics << "Error: No production " << lhs << " -> " << oldText << "." << endl;
+            return 0;
+        }
+
+        // the incremental path needs an analysed grammar and no change to the symbol set
+        int lhsId = symbols.lookup(lhs);
+        bool incremental = !tableRows.empty() && lhsId >= terminalCount && !(oldRhs && !newRhs && ir.rules[lhsIr].size() == 1);
+        for (const string& name : newBody) incremental = incremental && ir.names.lookup(name) >= 0 && symbols.lookup(name) > END_MARKER_ID;
+
+        // the grammar itself
+        vector<int> newIr;
+        for (const string& name : newBody) newIr.push_back(ir.symbol(name));
+        lhsIr = ir.symbol(lhs);
+        vector<IRSpan>& alternatives = ir.rules[lhsIr];
+        if (oldRhs && newRhs) alternatives[alternative] = ir.append({0, 0}, newIr);
+        else if (oldRhs) alternatives.erase(alternatives.begin() + alternative);
+        else alternatives.push_back(ir.append({0, 0}, newIr));
+
+        const size_t A = incremental ? (size_t)nonTerminalIndex(lhsId) : 0;
+        vector<int> oldIds, newIds;
+        if (incremental) {
+            if (usedBy.empty()) buildUsedBy();
+            for (const string& name : newBody) newIds.push_back(symbols.lookup(name));
+            if (oldRhs) oldIds = idRules[A][alternative];
+            countUses((int)A, oldIds, -1);
+            countUses((int)A, newIds, 1);
+            for (int symbol : oldIds) incremental = incremental && !(isTerminal(symbol) && usedBy[symbol].empty());
+        }
+        if (!incremental) {
+            set<pair<string, string>> before = conflictKeys();
+            computeFirst();
+            computeFollow();
+            computeParsingTable(false);
+            edit.incremental = false;
+            edit.firstRows = edit.followRows = edit.tableRows = idRules.size();
+            diffConflicts(before, conflictKeys(), edit);
+            return 1;
+        }
+
+        // renumber: production `number` is the edited one
+        int number = ruleOffsets[A] + (oldRhs ? alternative : (int)idRules[A].size());
+        if (oldRhs && newRhs) {
+            idRules[A][alternative] = newIds;
+            productionTexts[number] = newText;
+        } else {
+            int delta = newRhs ? 1 : -1;
+            if (newRhs) {
+                idRules[A].push_back(newIds);
+                productionTexts.insert(productionTexts.begin() + number, newText);
+            } else {
+                idRules[A].erase(idRules[A].begin() + alternative);
+                productionTexts.erase(productionTexts.begin() + number);
+            }
+            for (size_t nt = A + 1; nt < ruleOffsets.size(); ++nt) ruleOffsets[nt] += delta;
+            // only rows after A refer to later productions (A's own row is refilled below)
+            const int shiftFrom = newRhs ? number : number + 1;
+            for (size_t nt = A + 1; nt < tableRows.size(); ++nt) {
+                for (pair<int, int>& cell : tableRows[nt]) cell.second += cell.second >= shiftFrom ? delta : 0;
+            }
+        }
+
+        const size_t words = firstSets.words();
+        const uint64_t withoutEpsilon = ~(uint64_t(1) << EPSILON_ID);
+        auto isNullable = [&](int symbol) { return !isTerminal(symbol) && testBit(firstSets.row(nonTerminalIndex(symbol)), EPSILON_ID); };
+
+        // FIRST region: A and every non-terminal with a region member after a nullable prefix
+        vector<int> region = {(int)A};
+        vector<int> regionIndex(idRules.size(), -1);
+        regionIndex[A] = 0;
+        for (size_t i = 0; i < region.size(); ++i) {
+            int symbol = terminalCount + region[i];
+            for (const auto& [owner, uses] : usedBy[symbol]) {
+                if (regionIndex[owner] >= 0) continue;
+                bool reaches = false;
+                for (const vector<int>& prod : idRules[owner]) {
+                    for (int s : prod) {
+                        if (s == symbol) reaches = true;
+                        if (reaches || !isNullable(s)) break;
+                    }
+                    if (reaches) break;
+                }
+                if (!reaches) continue;
+                regionIndex[owner] = (int)region.size();
+                region.push_back(owner);
+            }
+        }
+
+        // nullable within the region (production counters, as in computeNullable); outside it nothing changes
+        vector<char> wasNullable(region.size()), nullable(region.size(), 0);
+        for (size_t i = 0; i < region.size(); ++i) wasNullable[i] = testBit(firstSets.row(region[i]), EPSILON_ID);
+        vector<int> pending, owner, worklist;
+        vector<vector<int>> usedIn(region.size());
+        for (size_t i = 0; i < region.size(); ++i) {
+            for (const vector<int>& prod : idRules[region[i]]) {
+                bool blocked = any_of(prod.begin(), prod.end(), [&](int s) {
+                    return isTerminal(s) || (regionIndex[nonTerminalIndex(s)] < 0 && !isNullable(s));
+                });
+                if (blocked) continue;
+                int p = (int)pending.size();
+                pending.push_back(0);
+                owner.push_back((int)i);
+                for (int s : prod) {
+                    int j = regionIndex[nonTerminalIndex(s)];
+                    if (j < 0) continue;
+                    pending[p]++;
+                    usedIn[j].push_back(p);
+                }
+                if (pending[p] == 0 && !nullable[i]) {
+                    nullable[i] = 1;
+                    worklist.push_back((int)i);
+                }
+            }
+        }
+        while (!worklist.empty()) {
+            int i = worklist.back();
+            worklist.pop_back();
+            for (int p : usedIn[i]) {
+                if (--pending[p] == 0 && !nullable[owner[p]]) {
+                    nullable[owner[p]] = 1;
+                    worklist.push_back(owner[p]);
+                }
+            }
+        }
+        // a symbol counts as nullable for FOLLOW if it was before the edit or is now
+        auto wasOrIsNullable = [&](int symbol) {
+            if (isTerminal(symbol)) return false;
+            int i = regionIndex[nonTerminalIndex(symbol)];
+            return i < 0 ? isNullable(symbol) : wasNullable[i] || nullable[i];
+        };
+
+        // FIRST of the region, with the rows outside it as fixed inputs
+        BitMatrix regionFirst;
+        regionFirst.reset(region.size(), terminalCount);
+        vector<vector<int>> deps(region.size());
+        for (size_t i = 0; i < region.size(); ++i) {
+            uint64_t* row = regionFirst.row(i);
+            for (const vector<int>& prod : idRules[region[i]]) {
+                for (int s : prod) {
+                    if (isTerminal(s)) {
+                        setBit(row, s);
+                        break;
+                    }
+                    int j = regionIndex[nonTerminalIndex(s)];
+                    if (j < 0) unionBits(row, firstSets.row(nonTerminalIndex(s)), words, withoutEpsilon);
+                    else if (j != (int)i) deps[i].push_back(j);
+                    if (j < 0 ? !isNullable(s) : !nullable[j]) break;
+                }
+            }
+            sort(deps[i].begin(), deps[i].end());
+            deps[i].erase(unique(deps[i].begin(), deps[i].end()), deps[i].end());
+        }
+        SolverStats stats;
+        solveInclusions(deps, regionFirst, stats);
+        vector<int> firstChanged;
+        for (size_t i = 0; i < region.size(); ++i) {
+            uint64_t* row = regionFirst.row(i);
+            if (nullable[i]) setBit(row, EPSILON_ID);
+            if (equal(row, row + words, firstSets.row(region[i]))) continue;
+            copy(row, row + words, firstSets.row(region[i]));
+            firstChanged.push_back(region[i]);
+        }
+        edit.firstRows = region.size();
+
+        // FOLLOW region: the seeds, then whatever inherits FOLLOW from a member through a nullable tail
+        vector<int> followRegion;
+        vector<int> followIndex(idRules.size(), -1);
+        auto addFollow = [&](int symbol) {
+            if (isTerminal(symbol) || followIndex[nonTerminalIndex(symbol)] >= 0) return;
+            followIndex[nonTerminalIndex(symbol)] = (int)followRegion.size();
+            followRegion.push_back(nonTerminalIndex(symbol));
+        };
+        for (int s : oldIds) addFollow(s);
+        for (int s : newIds) addFollow(s);
+        for (int nt : firstChanged) {
+            int symbol = terminalCount + nt;
+            for (const auto& [user, uses] : usedBy[symbol]) {
+                for (const vector<int>& prod : idRules[user]) {
+                    for (size_t k = 0; k < prod.size(); ++k) {
+                        if (prod[k] != symbol) continue;
+                        for (size_t j = k; j-- > 0;) {
+                            addFollow(prod[j]);
+                            if (!wasOrIsNullable(prod[j])) break;
+                        }
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < followRegion.size(); ++i) {
+            for (const vector<int>& prod : idRules[followRegion[i]]) {
+                for (size_t j = prod.size(); j-- > 0;) {
+                    addFollow(prod[j]);
+                    if (!wasOrIsNullable(prod[j])) break;
+                }
+            }
+        }
+
+        // FOLLOW of the region from every occurrence of its members, rows outside it as fixed inputs
+        BitMatrix regionFollow;
+        regionFollow.reset(followRegion.size(), terminalCount);
+        vector<vector<int>> followDeps(followRegion.size());
+        vector<uint64_t> suffixFirst(words);
+        for (size_t i = 0; i < followRegion.size(); ++i) {
+            uint64_t* row = regionFollow.row(i);
+            int symbol = terminalCount + followRegion[i];
+            if (followRegion[i] == startIndex) setBit(row, END_MARKER_ID);
+            for (const auto& [user, uses] : usedBy[symbol]) {
+                for (const vector<int>& prod : idRules[user]) {
+                    for (size_t k = 0; k < prod.size(); ++k) {
+                        if (prod[k] != symbol) continue;
+                        bool suffixNullable = firstOfSequence(prod.data() + k + 1, prod.data() + prod.size(), suffixFirst.data());
+                        unionBits(row, suffixFirst.data(), words, withoutEpsilon);
+                        if (!suffixNullable || user == followRegion[i]) continue;
+                        if (followIndex[user] >= 0) followDeps[i].push_back(followIndex[user]);
+                        else unionBits(row, followSets.row(user), words);
+                    }
+                }
+            }
+            sort(followDeps[i].begin(), followDeps[i].end());
+            followDeps[i].erase(unique(followDeps[i].begin(), followDeps[i].end()), followDeps[i].end());
+        }
+        solveInclusions(followDeps, regionFollow, stats);
+        vector<int> followChanged;
+        for (size_t i = 0; i < followRegion.size(); ++i) {
+            const uint64_t* row = regionFollow.row(i);
+            if (equal(row, row + words, followSets.row(followRegion[i]))) continue;
+            copy(row, row + words, followSets.row(followRegion[i]));
+            followChanged.push_back(followRegion[i]);
+        }
+        edit.followRows = followRegion.size();
+
+        // table rows: A, the users of a changed FIRST set and the owners of a changed FOLLOW set
+        vector<int> rows = {(int)A};
+        vector<char> refill(idRules.size(), 0);
+        refill[A] = 1;
+        auto addRow = [&](int nt) {
+            if (!refill[nt]) rows.push_back(nt);
+            refill[nt] = 1;
+        };
+        for (int nt : firstChanged) {
+            for (const auto& [user, uses] : usedBy[terminalCount + nt]) addRow(user);
+        }
+        for (int nt : followChanged) addRow(nt);
+
+        set<pair<string, string>> before, after;
+        vector<uint64_t> firstOfAlpha(words);
+        for (int nt : rows) {
+            const string& nonTerm = symbols.name(terminalCount + nt);
+            auto cells = conflicts.lower_bound(make_pair(nonTerm, string()));
+            while (cells != conflicts.end() && cells->first.first == nonTerm) {
+                before.insert(cells->first);
+                cells = conflicts.erase(cells);
+            }
+            auto entries = parsingTable.lower_bound(make_pair(nonTerm, string()));
+            while (entries != parsingTable.end() && entries->first.first == nonTerm) entries = parsingTable.erase(entries);
+            tableRows[nt].clear();
+
+            fillTableRow(nt, firstOfAlpha.data(), false);
+            cells = conflicts.lower_bound(make_pair(nonTerm, string()));
+            for (; cells != conflicts.end() && cells->first.first == nonTerm; ++cells) after.insert(cells->first);
+        }
+        edit.tableRows = rows.size();
+        diffConflicts(before, after, edit);
+        return 1;
+    }
+
+    set<pair<string, string>> conflictKeys() const {
+        set<pair<string, string>> keys;
+        for (const auto& [cell, conflict] : conflicts) keys.insert(keys.end(), cell);
+        return keys;
+    }
+
+    // Function to list the cells that are conflicts in after but not before, and the other way round
+    static void diffConflicts(const set<pair<string, string>>& before, const set<pair<string, string>>& after, GrammarEdit& edit) {
+        set_difference(after.begin(), after.end(), before.begin(), before.end(), back_inserter(edit.newConflicts));
+        set_difference(before.begin(), before.end(), after.begin(), after.end(), back_inserter(edit.resolvedConflicts));
+    }
+
+    // Function to number the terminals by their column in the printed and CSV tables (the name
+    // order of terminals); ε has no column
+    vector<int> tableColumns() const {
+        vector<int> columns(terminalCount, -1);
+        int column = 0;
+        for (const string& term : terminals) columns[symbols.lookup(term)] = column++;
+        return columns;
+    }
+
+    // Function to spread the row of nonTerm over those columns: the production text of every
+    // column, nullptr where the cell is empty
+    vector<const string*> tableRowTexts(const string& nonTerm, const vector<int>& columns) const {
+        vector<const string*> texts(terminals.size(), nullptr);
+        for (const pair<int, int>& cell : tableRows[nonTerminalIndex(symbols.lookup(nonTerm))]) {
+            texts[columns[cell.first]] = &productionTexts[cell.second];
+        }
+        return texts;
+    }
+
+    // Tables with more cells than this are summarized instead of drawn (see printParsingTable)
+    static constexpr size_t MAX_PRINTED_TABLE_CELLS = 1000000;
+
+    void printParsingTable() {
+        cout << "\nLL(1) Parsing Table:" << endl;
+
+        // a generated grammar of a few thousand rules already makes a grid of gigabytes
+        if (nonTerminals.size() * terminals.size() > MAX_PRINTED_TABLE_CELLS) {
+            cout << nonTerminals.size() << " non-terminals x " << terminals.size() << " terminals, " << tableCellCount()
+                 << " non-empty cells: too large to print, see ll1_parsing_table.csv" << endl;
+            return;
+        }
+
+        const int colWidth = 20;
+        map<pair<string, string>, string> truncatedEntries;
+
+        // Top border
+        cout << "+" << string(colWidth, '-');
+        for (const auto& term : terminals) cout << "+" << string(colWidth, '-');
+        cout << "+" << endl;
+
+        // Header row
+        cout << "|" << setw(colWidth) << left << " NT \\ Terminal";
+        for (const auto& term : terminals) cout << "|" << setw(colWidth) << left << term;
+        cout << "|" << endl;
+
+        // Separator line
+        cout << "+" << string(colWidth, '-');
+        for (size_t i = 0; i < terminals.size(); i++) cout << "+" << string(colWidth, '-');
+        cout << "+" << endl;
+
+        // MAIN PARSING TABLE
+        const vector<int> columns = tableColumns();
+        for (const auto& nonTerm : nonTerminals) {
+            cout << "|" << setw(colWidth) << left << nonTerm;
+
+            vector<const string*> texts = tableRowTexts(nonTerm, columns);
+            size_t column = 0;
+            for (const auto& term : terminals) {
+                pair<string, string> key = { nonTerm, term };
+                string cellContent;
+
+                if (const string* text = texts[column++]) {
+                    string production = *text;
+
+                    /*
+                    // replace epsilon with ^
+                    size_t pos;
+                    while ((pos = production.find("\u03B5")) != string::npos) production.replace(pos, 2, "^");
+                    */
+
+                    cellContent = nonTerm + " → " + production;
+
+                    // truncation
+                    if (cellContent.length() > colWidth) {
+                        // truncate after the arrow
+                        size_t truncPos = cellContent.find(' ', 10);
+
+                        if (truncPos == string::npos) truncPos = colWidth - 4;
+
+                        truncatedEntries[key] = production;
+                        cellContent = cellContent.substr(0, truncPos) + "...";
+                    }
+
+                }
+                else {
+                    // explicitly pad empty cells with spaces
+                    cellContent = string(colWidth, ' ');
+                }
+
+                cout << "|" << setw(colWidth) << left << cellContent;
+            }
+            cout << "|" << endl;
+        }
+
+        // bottom border
+        cout << "+" << string(colWidth, '-');
+        for (size_t i = 0; i < terminals.size(); i++) cout << "+" << string(colWidth, '-');
+        cout << "+" << endl;
+
+        // Key for truncated entries
+        if (!truncatedEntries.empty()) {
+            cout << "\nKey:\n";
+            cout << "* Truncated Entries (full production):\n";
+            for (const auto& entry : truncatedEntries) cout << "  - " << entry.first.first << " → " << entry.second << endl;
+        }
+        cout << "* Empty cells indicate no production\n";
+    }
+
+    void writeParsingTableToCSV(const string& filename) {
+        ofstream csvFile(filename);
+        if (!csvFile.is_open()) {
+            cerr << "Error: Could not open file " << filename << endl;
+            return;
+        }
+
+        // Write CSV header (terminals)
+        csvFile << "Non-Terminal";
+        for (const auto& term : terminals) csvFile << "," << term;
+        csvFile << "\n";
+
+        // Write rows for each non-terminal
+        const vector<int> columns = tableColumns();
+        for (const auto& nonTerm : nonTerminals) {
+            csvFile << nonTerm; // First column: non-terminal
+
+            for (const string* text : tableRowTexts(nonTerm, columns)) {
+                string production;
+
+                if (text) {
+                    production = nonTerm + " → " + *text;
+
+                    /*
+                    // Replace ε with ^
+                    size_t pos;
+                    while ((pos = production.find("ε")) != string::npos) production.replace(pos, 2, "^");
+                    */
+                }
+
+                csvFile << "," << production;
+            }
+            csvFile << "\n";
+        }
+
+        csvFile.close();
+        cout << "Parsing table saved to " << filename << endl;
+    }
+
+    // Write the table in the compiled binary format (ParseTableFormat.h) that Stack maps directly.
+    // ε is not a symbol in that format, so every grammar ID shifts down by one.
+    // flags may ask for the compressed action table (ZLL1_FLAG_COMPRESSED_ACTIONS, optionally
+    // with ZLL1_FLAG_DEFAULT_PRODUCTIONS); only then is the table compressed and its size reported.
+    void writeParsingTableToBinary(const string& filename, uint32_t flags = 0) {
+        ZLL1CompressionStats stats;
+        ZLL1ChainStats chainStats;
+        vector<char> image = parsingTableImage(flags, &stats, &chainStats);
+        const int columns = terminalCount - 1;
+        if (flags & ZLL1_FLAG_EXPANSION_CHAINS) {
+            cout << "Expansion chains: " << chainStats.cells << " cells start " << chainStats.expansions
+                 << " expansions, folded into " << chainStats.chains << " chains (" << chainStats.rhs_symbols
+                 << " RHS symbols)" << endl;
+        }
+        if (flags & (ZLL1_FLAG_COMPRESSED_ACTIONS | ZLL1_FLAG_DEFAULT_PRODUCTIONS)) {
+            cout << "Action table: " << stats.rows << " rows (" << stats.merged_rows << " distinct) x " << columns
+                 << " columns, " << stats.cells << " non-empty cells; dense " << stats.dense_bytes << " bytes, compressed "
+                 << stats.compressed_bytes << " bytes (" << fixed << setprecision(2)
+                 << (double)stats.dense_bytes / max<size_t>(stats.compressed_bytes, 1) << "x, " << stats.comb_entries
+                 << " entries in a comb of " << stats.comb_size << ")" << defaultfloat << setprecision(6) << endl;
+        } else {
+            cout << "Action table: " << stats.rows << " rows x " << columns << " columns, " << stats.cells
+                 << " non-empty cells; dense " << stats.dense_bytes << " bytes" << endl;
+        }
+
+        ofstream binFile(filename, ios::binary);
+        if (!binFile.is_open()) {
+            cerr << "Error: Could not open file " << filename << endl;
+            return;
+        }
+        binFile.write(image.data(), (streamsize)image.size());
+        binFile.close();
+        cout << "Compiled parsing table saved to " << filename
+             << ((flags & ZLL1_FLAG_COMPRESSED_ACTIONS) ? " (compressed actions)" : "") << endl;
+    }
+
+    // Function to build the binary table in memory, as written by writeParsingTableToBinary
+    // (ZLL1_FLAG_EXPANSION_CHAINS in flags folds multi-step expansions into chains first)
+    vector<char> parsingTableImage(uint32_t flags = 0, ZLL1CompressionStats* stats = nullptr, ZLL1ChainStats* chainStats = nullptr) {
+        if (tableRows.empty()) computeParsingTable();
+
+        vector<string> symbolNames;
+        for (int id = 1; id < symbols.size(); ++id) symbolNames.push_back(symbols.name(id));
+        const int columns = terminalCount - 1;
+
+        vector<ZLL1SourceProduction> productions;
+        size_t nt = 0;
+        for (; nt < idRules.size(); ++nt) {
+            for (size_t p = 0; p < idRules[nt].size(); ++p) {
+                ZLL1SourceProduction production;
+                production.lhs = terminalCount + (int)nt - 1;
+                for (int symbol : idRules[nt][p]) production.rhs.push_back(symbol - 1);
+                production.text = productionTexts[ruleOffsets[nt] + p];
+                productions.push_back(std::move(production));
+            }
+        }
+
+        // the rows without the ε column (ε never has a cell)
+        vector<ZLL1ActionRow> rows(idRules.size());
+        for (size_t row = 0; row < idRules.size(); ++row) {
+            rows[row].reserve(tableRows[row].size());
+            for (const pair<int, int>& cell : tableRows[row]) rows[row].emplace_back((uint32_t)(cell.first - 1), cell.second);
+        }
+
+        uint32_t chains = 0;
+        if (flags & ZLL1_FLAG_EXPANSION_CHAINS) {
+            chains = zll1_expansion_chains(rows, (uint32_t)columns, productions, symbolNames, chainStats);
+        }
+
+        // either the row displacement of the table or the dense matrix, never both
+        if (flags & ZLL1_FLAG_DEFAULT_PRODUCTIONS) flags |= ZLL1_FLAG_COMPRESSED_ACTIONS;
+        vector<int32_t> actions = (flags & ZLL1_FLAG_COMPRESSED_ACTIONS)
+            ? zll1_compress_actions(rows, (uint32_t)columns, (flags & ZLL1_FLAG_DEFAULT_PRODUCTIONS) != 0, stats)
+            : zll1_dense_actions(rows, (uint32_t)columns, stats);
+        rows.clear();
+        rows.shrink_to_fit();
+
+        int32_t start = terminalCount + max(startIndex, 0) - 1;
+        return zll1_build(symbolNames, columns, start, productions, actions, flags, chains);
+    }
+
+    // Function to write a name as a C string literal
+    static string cStringLiteral(const string& text) {
+        string literal = "\"";
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') {
+                literal += '\\';
+                literal += (char)c;
+            } else if (c < 0x20 || c >= 0x7f) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\%03o", c);
+                literal += escaped;
+            } else {
+                literal += (char)c;
+            }
+        }
+        return literal + "\"";
+    }
+
+    // Function to make a symbol name safe inside a // comment
+    static string commentText(const string& text) {
+        string safe;
+        for (char c : text) safe += c == '\\' ? '/' : c;
+        return safe;
+    }
+
+    // Write a standalone C++ parser for this grammar: the table is compiled into code, with one
+    // switch arm per non-terminal on an explicit stack and the lookahead dispatch as an inner
+    // switch. A production that starts with a terminal consumes it in place instead of pushing it.
+    void writeDirectParser(const string& filename) {
+        if (tableRows.empty()) computeParsingTable();
+
+        ofstream out(filename);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << filename << endl;
+            return;
+        }
+
+        // production texts by global production number
+        vector<string> productionText;
+        vector<int> productionLhs;
+        size_t nt = 0;
+        for (const string& nonTerm : nonTerminals) {
+            for (size_t p = 0; p < idRules[nt].size(); ++p) {
+                productionText.push_back(nonTerm + " -> " + productionTexts[ruleOffsets[nt] + p]);
+                productionLhs.push_back(symbols.lookup(nonTerm));
+            }
+            ++nt;
+        }
+        auto symbolComment = [this](int id) { return "/* " + commentText(symbols.name(id)) + " */"; };
+        // comment text must not close the comment
+        for (string& text : productionText) {
+            for (size_t pos; (pos = text.find("*/")) != string::npos;) text.replace(pos, 2, "* /");
+        }
+
+        out << "// Direct-coded LL(1) parser generated by Parser --emit-cpp. Do not edit.\n"
+               "//\n"
+               "// Reads one sentence per line, like Stack, and reports rejected lines and totals.\n"
+               "// Define ZETA_DIRECT_PARSER_NO_MAIN to use zeta_direct_parse_line from a library.\n"
+               "//\n"
+               "// usage: <parser> [--quiet] [input-file | -]\n"
+               "#include <stdio.h>\n#include <stdlib.h>\n#include <string.h>\n#include <time.h>\n"
+               "#include <fcntl.h>\n#include <sys/mman.h>\n#include <sys/stat.h>\n#include <unistd.h>\n\n";
+
+        out << "#define END_MARKER " << END_MARKER_ID << "\n";
+        out << "#define START_SYMBOL " << terminalCount + max(startIndex, 0) << " " << symbolComment(terminalCount + max(startIndex, 0)) << "\n\n";
+
+        out << "static const char *const SYMBOL_NAMES[] = {\n";
+        for (int id = 0; id < symbols.size(); ++id) out << "    " << cStringLiteral(symbols.name(id)) << ",\n";
+        out << "};\n\n";
+
+        // Terminal lookup: by length, then a switch on the first byte for single characters
+        // or a memcmp chain otherwise. "$" is not an input token.
+        map<size_t, vector<int>> byLength;
+        for (int id = 0; id < terminalCount; ++id) {
+            if (id == EPSILON_ID || id == END_MARKER_ID) continue;
+            byLength[symbols.name(id).size()].push_back(id);
+        }
+        out << "// Terminal ID of a token, -1 if it is not a terminal of the grammar\n";
+        out << "static inline int lookup_terminal(const char *s, size_t n) {\n";
+        out << "    switch (n) {\n";
+        for (const auto& group : byLength) {
+            out << "    case " << group.first << ":\n";
+            if (group.first == 1) {
+                out << "        switch (s[0]) {\n";
+                for (int id : group.second) {
+                    out << "        case " << (int)(signed char)symbols.name(id)[0] << ": return " << id << "; " << symbolComment(id) << "\n";
+                }
+                out << "        default: return -1;\n        }\n";
+            } else {
+                for (int id : group.second) {
+                    out << "        if (memcmp(s, " << cStringLiteral(symbols.name(id)) << ", " << group.first << ") == 0) return " << id << ";\n";
+                }
+                out << "        return -1;\n";
+            }
+        }
+        out << "    default:\n        return -1;\n    }\n}\n\n";
+
+        out << "// Tokens of one line, separated by blanks\n"
+               "typedef struct {\n    const char *pos;\n    const char *end;\n} Lexer;\n\n"
+               "static inline bool is_separator(char c) {\n"
+               "    return c == ' ' || c == '\\t' || c == '\\r' || c == '\\f' || c == '\\v';\n}\n\n"
+               "static inline int next_token(Lexer *lx) {\n"
+               "    while (lx->pos < lx->end && is_separator(*lx->pos)) lx->pos++;\n"
+               "    if (lx->pos == lx->end) return END_MARKER;\n"
+               "    const char *start = lx->pos;\n"
+               "    while (lx->pos < lx->end && !is_separator(*lx->pos)) lx->pos++;\n"
+               "    return lookup_terminal(start, (size_t)(lx->pos - start));\n}\n\n";
+
+        out << "// Parse stack, reused across lines\n"
+               "static int *stack = NULL;\n"
+               "static size_t stack_capacity = 0;\n\n"
+               "static void grow_stack(size_t needed) {\n"
+               "    size_t capacity = stack_capacity ? stack_capacity : 256;\n"
+               "    while (capacity < needed) capacity *= 2;\n"
+               "    int *grown = (int *)realloc(stack, capacity * sizeof(int));\n"
+               "    if (!grown) {\n        fprintf(stderr, \"Out of memory!\\n\");\n        exit(EXIT_FAILURE);\n    }\n"
+               "    stack = grown;\n    stack_capacity = capacity;\n}\n\n";
+
+        out << "// Parse the line [begin, end). Returns true if it is a sentence of the grammar;\n"
+               "// *tokens receives the number of tokens matched.\n"
+               "bool zeta_direct_parse_line(const char *begin, const char *end, size_t *tokens) {\n"
+               "    Lexer lx = {begin, end};\n"
+               "    int token = next_token(&lx);\n"
+               "    size_t matched = 0;\n"
+               "    size_t sp = 0;\n"
+               "    if (stack_capacity < 2) grow_stack(2);\n"
+               "    stack[sp++] = END_MARKER;\n"
+               "    stack[sp++] = START_SYMBOL;\n\n"
+               "    for (;;) {\n"
+               "        switch (stack[sp - 1]) {\n";
+
+        for (size_t nt = 0; nt < idRules.size(); ++nt) {
+            int id = terminalCount + (int)nt;
+            out << "        case " << id << ": " << symbolComment(id) << "\n";
+            out << "            switch (token) {\n";
+
+            // group the lookahead terminals by production
+            map<int, vector<int>> cases;
+            for (const pair<int, int>& cell : tableRows[nt]) cases[cell.second].push_back(cell.first);
+            for (const auto& entry : cases) {
+                int production = entry.first;
+                const vector<int>& rhs = idRules[nt][production - ruleOffsets[nt]];
+                // a leading terminal is the lookahead itself and is matched right away
+                bool consume = !rhs.empty() && isTerminal(rhs[0]) && entry.second.size() == 1 && entry.second[0] == rhs[0];
+                size_t keep = consume ? 1 : 0;
+
+                for (int term : entry.second) out << "            case " << term << ": " << symbolComment(term) << "\n";
+                out << "            {   // " << commentText(productionText[production]) << "\n";
+                out << "                sp--;\n";
+                if (rhs.size() > keep) {
+                    out << "                if (sp + " << rhs.size() - keep << " > stack_capacity) grow_stack(sp + " << rhs.size() - keep << ");\n";
+                    for (size_t i = rhs.size(); i-- > keep;) {
+                        out << "                stack[sp++] = " << rhs[i] << "; " << symbolComment(rhs[i]) << "\n";
+                    }
+                }
+                if (consume) out << "                matched++;\n                token = next_token(&lx);\n";
+                out << "                continue;\n            }\n";
+            }
+            out << "            default:\n                *tokens = matched;\n                return false;\n            }\n";
+        }
+
+        out << "        default: // terminal on top\n"
+               "            if (stack[sp - 1] != token) {\n                *tokens = matched;\n                return false;\n            }\n"
+               "            if (token == END_MARKER) {\n                *tokens = matched;\n                return true;\n            }\n"
+               "            sp--;\n"
+               "            matched++;\n"
+               "            token = next_token(&lx);\n"
+               "        }\n"
+               "    }\n"
+               "}\n\n";
+
+        out << "#ifndef ZETA_DIRECT_PARSER_NO_MAIN\n"
+               "int main(int argc, char *argv[]) {\n"
+               "    const char *path = \"input_strings.txt\";\n"
+               "    bool quiet = false;\n"
+               "    for (int i = 1; i < argc; i++) {\n"
+               "        if (strcmp(argv[i], \"--quiet\") == 0) quiet = true;\n"
+               "        else path = argv[i];\n"
+               "    }\n\n"
+               "    // the whole input in memory: mapped, or read from stdin\n"
+               "    const char *data = NULL;\n"
+               "    size_t size = 0;\n"
+               "    if (strcmp(path, \"-\") == 0) {\n"
+               "        size_t capacity = 1 << 20;\n"
+               "        char *buffer = (char *)malloc(capacity);\n"
+               "        size_t n;\n"
+               "        while (buffer && (n = fread(buffer + size, 1, capacity - size, stdin)) > 0) {\n"
+               "            size += n;\n"
+               "            if (size == capacity) buffer = (char *)realloc(buffer, capacity *= 2);\n"
+               "        }\n"
+               "        if (!buffer) {\n            fprintf(stderr, \"Out of memory!\\n\");\n            return EXIT_FAILURE;\n        }\n"
+               "        data = buffer;\n"
+               "    } else {\n"
+               "        int fd = open(path, O_RDONLY);\n"
+               "        struct stat st;\n"
+               "        if (fd < 0 || fstat(fd, &st) != 0) {\n            perror(\"Error opening input file\");\n            return EXIT_FAILURE;\n        }\n"
+               "        size = (size_t)st.st_size;\n"
+               "        if (size > 0) {\n"
+               "            void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);\n"
+               "            if (mapping == MAP_FAILED) {\n                perror(\"Error mapping input file\");\n                return EXIT_FAILURE;\n            }\n"
+               "            madvise(mapping, size, MADV_SEQUENTIAL);\n"
+               "            data = (const char *)mapping;\n"
+               "        }\n"
+               "        close(fd);\n"
+               "    }\n\n"
+               "    struct timespec started, finished;\n"
+               "    clock_gettime(CLOCK_MONOTONIC, &started);\n"
+               "    size_t lines = 0, accepted = 0, total_tokens = 0, line_number = 0;\n"
+               "    const char *end = data + size;\n"
+               "    for (const char *p = data; p < end;) {\n"
+               "        const char *newline = (const char *)memchr(p, '\\n', (size_t)(end - p));\n"
+               "        const char *line_end = newline ? newline : end;\n"
+               "        line_number++;\n"
+               "        // skip blank lines, as Stack does\n"
+               "        const char *q = p;\n"
+               "        while (q < line_end && is_separator(*q)) q++;\n"
+               "        if (q < line_end) {\n"
+               "            size_t tokens = 0;\n"
+               "            bool ok = zeta_direct_parse_line(p, line_end, &tokens);\n"
+               "            lines++;\n"
+               "            total_tokens += tokens;\n"
+               "            if (ok) accepted++;\n"
+               "            else if (!quiet) printf(\"line %zu: rejected after %zu tokens\\n\", line_number, tokens);\n"
+               "        }\n"
+               "        p = newline ? newline + 1 : end;\n"
+               "    }\n"
+               "    clock_gettime(CLOCK_MONOTONIC, &finished);\n"
+               "    double seconds = (double)(finished.tv_sec - started.tv_sec) + (double)(finished.tv_nsec - started.tv_nsec) / 1e9;\n"
+               "    printf(\"Parsed %zu lines: %zu accepted, %zu rejected, %zu tokens in %.3f s (%.0f tokens/s)\\n\",\n"
+               "           lines, accepted, lines - accepted, total_tokens, seconds, seconds > 0 ? (double)total_tokens / seconds : 0.0);\n"
+               "    return accepted == lines ? EXIT_SUCCESS : EXIT_FAILURE;\n"
+               "}\n"
+               "#endif\n";
+
+        out.close();
+        cout << "Direct-coded parser saved to " << filename << endl;
+    }
+
+};
+
+#endif // ZETA_GRAMMAR_H
@@ -0,0 +1,211 @@
+//
+// Machine-readable exports of an analysed Grammar (Parser --export-jsonl / --export-binary):
+// the transformed grammar, FIRST and FOLLOW sets, the parsing table and its conflicts.
+//
+// Both formats are written record by record straight from Grammar's ID structures: sets are
+// read a word at a time from the bit matrices, the table from tableRows and productions
+// from idRules, so nothing is copied, sorted or truncated on the way out. Symbols use the
+// analysis IDs (ε = 0, $ = 1, terminals, then non-terminals) and productions their number.
+//
+// JSON lines, one object per line, in this order:
+//   {"type":"grammar","symbols":n,"terminals":n,"productions":n,"start":id}
+//   {"type":"symbol","id":0,"name":"ε","terminal":true}                    every symbol
+//   {"type":"production","id":0,"lhs":id,"rhs":[id,...]}                  every production
+//   {"type":"first","nonTerminal":id,"terminals":[id,...]}                 ε (0) when nullable
+//   {"type":"follow","nonTerminal":id,"terminals":[id,...]}
+//   {"type":"cell","nonTerminal":id,"terminal":id,"production":id}         every filled cell
+//   {"type":"conflict","nonTerminal":id,"terminal":id,"productions":[id,...],"fromFollow":b}
+//
+// Binary (native byte order, all fields uint32_t unless noted):
+//   ZGXHeader
+//   symbols[num_symbols]          name length, then that many bytes (no terminator)
+//   productions[num_productions]  lhs, rhs length, rhs IDs
+//   first[num_non_terminals]      set_words uint64_t each, bit i = terminal i
+//   follow[num_non_terminals]     the same
+//   cells[num_cells]              non-terminal, terminal, production
+//   conflicts[num_conflicts]      non-terminal, terminal, flags (1 = from FOLLOW),
+//                                 count, then count production IDs in claim order
+//
+#ifndef ZETA_GRAMMAR_EXPORT_H
+#define ZETA_GRAMMAR_EXPORT_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <bit>
+#include <cstdint>
+#include "Grammar.h"
+
+using namespace std;
+
+#define ZGX_MAGIC 0x3158475Au  // "ZGX1"
+#define ZGX_VERSION 1
+
+struct ZGXHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_symbols;
+    uint32_t num_terminals;          // IDs [0, num_terminals) are terminals, ε and $ included
+    uint32_t num_productions;
+    uint32_t start;                  // start symbol ID
+    uint32_t set_words;              // 64-bit words per FIRST/FOLLOW row
+    uint32_t num_cells;
+    uint32_t num_conflicts;
+    uint32_t reserved;
+};
+
+// Function to call f(bit) for every bit set in a row, in increasing order
+template <typename F>
+inline void forEachBit(const uint64_t* bits, size_t words, F&& f) {
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) f((int)(w * 64 + countr_zero(word)));
+    }
+}
+
+// Function to write text as a JSON string literal
+inline void writeJsonString(ostream& out, const string& text) {
+    out << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << (char)c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << (char)c;
+        }
+    }
+    out << '"';
+}
+
+// Function to find the number of a production of non-terminal nt by its text (-1 if none)
+inline int productionNumber(const Grammar& g, size_t nt, const string& text) {
+    for (size_t p = 0; p < g.idRules[nt].size(); ++p) {
+        if (g.productionTexts[g.ruleOffsets[nt] + p] == text) return g.ruleOffsets[nt] + (int)p;
+    }
+    return -1;
+}
+
+// Function to write the analysis of g as JSON lines
+inline void exportJsonLines(const Grammar& g, ostream& out) {
+    const int symbolCount = g.symbols.size();
+    const size_t words = g.firstSets.words();
+    out << "{\"type\":\"grammar\",\"symbols\":" << symbolCount << ",\"terminals\":" << g.terminalCount
+        << ",\"productions\":" << g.productionTexts.size() << ",\"start\":" << g.terminalCount + g.startIndex << "}\n";
+
+    for (int id = 0; id < symbolCount; ++id) {
+        out << "{\"type\":\"symbol\",\"id\":" << id << ",\"name\":";
+        writeJsonString(out, g.symbols.name(id));
+        out << ",\"terminal\":" << (g.isTerminal(id) ? "true" : "false") << "}\n";
+    }
+
+    for (size_t nt = 0; nt < g.idRules.size(); ++nt) {
+        for (size_t p = 0; p < g.idRules[nt].size(); ++p) {
+            out << "{\"type\":\"production\",\"id\":" << g.ruleOffsets[nt] + p << ",\"lhs\":" << g.terminalCount + nt << ",\"rhs\":[";
+            const char* separator = "";
+            for (int symbol : g.idRules[nt][p]) {
+                out << separator << symbol;
+                separator = ",";
+            }
+            out << "]}\n";
+        }
+    }
+
+    for (const BitMatrix* sets : {&g.firstSets, &g.followSets}) {
+        const char* type = sets == &g.firstSets ? "first" : "follow";
+        for (size_t nt = 0; nt < sets->rows(); ++nt) {
+            out << "{\"type\":\"" << type << "\",\"nonTerminal\":" << g.terminalCount + nt << ",\"terminals\":[";
+            const char* separator = "";
+            forEachBit(sets->row(nt), words, [&](int term) {
+                out << separator << term;
+                separator = ",";
+            });
+            out << "]}\n";
+        }
+    }
+
+    for (size_t nt = 0; nt < g.tableRows.size(); ++nt) {
+        for (const auto& [term, production] : g.tableRows[nt]) {
+            out << "{\"type\":\"cell\",\"nonTerminal\":" << g.terminalCount + nt << ",\"terminal\":" << term
+                << ",\"production\":" << production << "}\n";
+        }
+    }
+
+    for (const auto& [key, conflict] : g.conflicts) {
+        int nt = g.nonTerminalIndex(g.symbols.lookup(key.first));
+        out << "{\"type\":\"conflict\",\"nonTerminal\":" << g.terminalCount + nt << ",\"terminal\":" << g.symbols.lookup(key.second)
+            << ",\"productions\":[";
+        for (size_t i = 0; i < conflict.productions.size(); ++i) out << (i ? "," : "") << productionNumber(g, nt, conflict.productions[i]);
+        out << "],\"fromFollow\":" << (conflict.fromFollow ? "true" : "false") << "}\n";
+    }
+}
+
+// Function to write the analysis of g in the binary export format
+inline void exportBinary(const Grammar& g, ostream& out) {
+    auto put = [&out](uint32_t value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    const size_t words = g.firstSets.words();
+
+    ZGXHeader header = {};
+    header.magic = ZGX_MAGIC;
+    header.version = ZGX_VERSION;
+    header.num_symbols = (uint32_t)g.symbols.size();
+    header.num_terminals = (uint32_t)g.terminalCount;
+    header.num_productions = (uint32_t)g.productionTexts.size();
+    header.start = (uint32_t)(g.terminalCount + g.startIndex);
+    header.set_words = (uint32_t)words;
+    header.num_cells = (uint32_t)g.tableCellCount();
+    header.num_conflicts = (uint32_t)g.conflicts.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (int id = 0; id < g.symbols.size(); ++id) {
+        const string& name = g.symbols.name(id);
+        put((uint32_t)name.size());
+        out.write(name.data(), (streamsize)name.size());
+    }
+
+    for (size_t nt = 0; nt < g.idRules.size(); ++nt) {
+        for (const vector<int>& prod : g.idRules[nt]) {
+            put((uint32_t)(g.terminalCount + nt));
+            put((uint32_t)prod.size());
+            out.write(reinterpret_cast<const char*>(prod.data()), (streamsize)(prod.size() * sizeof(int)));
+        }
+    }
+
+    for (const BitMatrix* sets : {&g.firstSets, &g.followSets}) {
+        if (sets->rows() > 0) out.write(reinterpret_cast<const char*>(sets->row(0)), (streamsize)(sets->rows() * words * sizeof(uint64_t)));
+    }
+
+    for (size_t nt = 0; nt < g.tableRows.size(); ++nt) {
+        for (const auto& [term, production] : g.tableRows[nt]) {
+            put((uint32_t)(g.terminalCount + nt));
+            put((uint32_t)term);
+            put((uint32_t)production);
+        }
+    }
+
+    for (const auto& [key, conflict] : g.conflicts) {
+        int nt = g.nonTerminalIndex(g.symbols.lookup(key.first));
+        put((uint32_t)(g.terminalCount + nt));
+        put((uint32_t)g.symbols.lookup(key.second));
+        put(conflict.fromFollow ? 1u : 0u);
+        put((uint32_t)conflict.productions.size());
+        for (const string& text : conflict.productions) put((uint32_t)productionNumber(g, nt, text));
+    }
+}
+
+// Function to write one of the exports to a file, reporting where it went
+inline bool exportAnalysis(const Grammar& g, const string& filename, bool binary) {
+    ofstream out(filename, binary ? ios::binary : ios::out);
+    if (!out) {
+        cerr << "Error: Could not open file " << filename << endl;
+        return false;
+    }
+    if (binary) exportBinary(g, out);
+    else exportJsonLines(g, out);
+    cout << "Analysis exported to " << filename << (binary ? " (binary)" : " (JSON lines)") << endl;
+    return true;
+}
+
+#endif // ZETA_GRAMMAR_EXPORT_H
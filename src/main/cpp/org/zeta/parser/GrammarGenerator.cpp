@@ -0,0 +1,351 @@
+//
+// Generates synthetic grammars in the cfg.txt format for load-testing the Grammar pipeline.
+//
+// The grammars are LL(1) by construction once Parser has left-factored them and removed
+// left recursion:
+//   - every alternative of N<i> starts with a terminal private to N<i> (a<i>_<k>), so the
+//     alternatives of a rule never share a FIRST terminal
+//   - a rule only refers to non-terminals with a higher index, so the grammar is a forest
+//     below P -> N0 ; P | ε and every non-terminal is reachable through a parent link
+//   - every non-terminal on a RHS is followed by a separator terminal (s<k>); separators never
+//     start an alternative, so FOLLOW sets stay disjoint from the FIRST sets of ε rules
+//   - shared prefixes copy the start of an earlier alternative and continue with a fresh
+//     private terminal, so left factoring leaves alternatives that differ in their first symbol
+//   - left recursion N<i> -> N<i> r<i> ... uses a terminal private to that rule as well
+// Private terminals make the terminal count grow as fast as the production count, and the
+// parsing table with the square of the grammar. --terminals=N draws those terminals from a
+// shared pool t0 .. t<N-1> instead: distinct among the alternatives of a rule, and after a
+// shared prefix also distinct from the leading terminals of every non-terminal the rule refers
+// to (and, where the prefix ends in N<j>, from every pool terminal N<j> uses, since it lands in
+// FOLLOW(N<j>)), so left factoring still leaves alternatives with disjoint FIRST sets. Where
+// the pool has no such terminal left, the private one is used.
+// --conflicts adds alternatives that break these rules on purpose: FIRST/FIRST conflicts
+// (N<j> s.. | a<j>_0 ..) and FIRST/FOLLOW conflicts (a nullable N<j> followed by a<j>_0).
+// --dead adds rules the grammar reduction in Parser removes again: an unreachable copy U<i>
+// of a rule, a copy R<i> that its parent refers to instead of N<i> (N<i> is then unreachable
+// and removed; R<i> stays as it is, so reduction counts it as an unreachable symbol rather
+// than a merge), or an alternative x<i> X<i> s.. through a non-terminal X<i> -> x<i> X<i>
+// that never ends.
+//
+// usage: GrammarGenerator [--nonterminals=100] [--alternatives=3] [--rhs-length=4]
+//                         [--epsilon=0.1] [--shared-prefix=0.1] [--left-recursion=0.1]
+//                         [--conflicts=0] [--dead=0] [--separators=8] [--terminals=0]
+//                         [--seed=1] [--output=FILE]
+//
+// Sizes a Release build of Parser is known to handle on one core, with --alternatives=5:
+//   --nonterminals=30000 --terminals=500   (100k productions)  50 s, 300 MB; 120 MB with --compress-table
+//   --nonterminals=100000 --terminals=500  (340k productions)  8.5 min, 400 MB with --compress-table
+//   --nonterminals=30000                   (87k productions, 81k terminals) only with --compress-table:
+//                                          4 min, 1.1 GB; the dense table would need 15.8 GB
+//
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <random>
+
+using namespace std;
+
+// Generator settings, see usage above
+struct GeneratorOptions {
+    int nonTerminals = 100;
+    int alternatives = 3;            // alternatives per rule are drawn from [1, alternatives]
+    int rhsLength = 4;               // RHS lengths are drawn from [1, rhsLength]
+    double epsilon = 0.1;            // probability that a rule also has an ε alternative
+    double sharedPrefix = 0.1;       // probability that an alternative shares a prefix with an earlier one
+    double leftRecursion = 0.1;      // probability that a rule gets an immediately left-recursive alternative
+    double conflicts = 0.0;          // probability that a rule gets a deliberately conflicting alternative
+    double dead = 0.0;               // probability that a rule gets an unreachable, duplicate or non-productive companion
+    int separators = 8;
+    int terminals = 0;               // size of the shared pool of leading terminals, 0 for private ones
+    unsigned seed = 1;
+};
+
+class GrammarGenerator {
+public:
+    explicit GrammarGenerator(const GeneratorOptions& options) : opt(options), rng(options.seed) {}
+
+    // Function to generate the whole grammar as cfg.txt text
+    string generate() {
+        int n = opt.nonTerminals;
+        rules.assign(n, {});
+        nullable.assign(n, false);
+        firstStart.assign(n, "");
+        leading.assign(n, {});
+        pooled.assign(n, {});
+        loopStart.assign(n, "");
+        poolUsed.assign(opt.terminals, 0);
+        dead.assign(n, NO_DEAD_RULE);
+        for (int i = 1; i < n; ++i) {
+            if (chance(opt.dead)) dead[i] = uniform_int_distribution<int>(UNREACHABLE_COPY, NON_PRODUCTIVE)(rng);
+        }
+
+        // parent links make every non-terminal reachable from N0
+        vector<vector<int>> children(n);
+        for (int j = 1; j < n; ++j) children[uniform_int_distribution<int>(0, j - 1)(rng)].push_back(j);
+
+        // bottom-up, so whether a referenced non-terminal is nullable is already known
+        for (int i = n - 1; i >= 0; --i) generateRule(i, children[i]);
+
+        ostringstream out;
+        out << "P -> N0 ; P | ε\n";
+        for (int i = 0; i < n; ++i) {
+            out << name(i) << " ->";
+            for (size_t k = 0; k < rules[i].size(); ++k) {
+                out << (k ? " |" : "");
+                for (const string& symbol : rules[i][k]) out << " " << symbol;
+            }
+            out << "\n";
+            productionCount += rules[i].size();
+        }
+        for (int i = 0; i < n; ++i) {
+            if (dead[i] == UNREACHABLE_COPY) writeCopy(out, i, "U");
+            else if (dead[i] == DUPLICATE_COPY) writeCopy(out, i, "R");
+            else if (dead[i] == NON_PRODUCTIVE) {
+                out << "X" << i << " -> " << loopStart[i] << " X" << i << "\n";
+                productionCount++;
+            }
+        }
+        productionCount += 2;
+        return out.str();
+    }
+
+    size_t productions() const { return productionCount; }
+    size_t terminals() const { return terminalCount + opt.separators + 1; }
+
+private:
+    GeneratorOptions opt;
+    mt19937 rng;
+    vector<vector<vector<string>>> rules;
+    vector<bool> nullable;
+    vector<string> firstStart;       // terminal starting the first alternative of each rule
+    vector<vector<string>> leading;  // terminals starting the alternatives of each rule
+    vector<vector<string>> pooled;   // pool terminals each rule uses anywhere
+    vector<string> loopStart;        // terminal of X<i> -> x X<i>, see --dead
+    vector<char> poolUsed;           // pool terminals used so far, see --terminals
+    size_t productionCount = 0;
+    size_t terminalCount = 0;        // private and pool terminals
+
+    // companion rule of each non-terminal, see --dead
+    enum { NO_DEAD_RULE, UNREACHABLE_COPY, DUPLICATE_COPY, NON_PRODUCTIVE };
+    vector<int> dead;
+
+    string name(int i) const { return "N" + to_string(i); }
+
+    // Function to write the rule of N<i> again under the name <prefix><i>
+    void writeCopy(ostream& out, int i, const string& prefix) {
+        out << prefix << i << " ->";
+        for (size_t k = 0; k < rules[i].size(); ++k) {
+            out << (k ? " |" : "");
+            for (const string& symbol : rules[i][k]) out << " " << (symbol == name(i) ? prefix + to_string(i) : symbol);
+        }
+        out << "\n";
+        productionCount += rules[i].size();
+    }
+
+    bool chance(double p) { return p > 0 && bernoulli_distribution(p)(rng); }
+
+    string freshTerminal(int i, int k) {
+        terminalCount++;
+        return "a" + to_string(i) + "_" + to_string(k);
+    }
+
+    string poolTerminal(int t) {
+        if (!poolUsed[t]) terminalCount++;
+        poolUsed[t] = 1;
+        return "t" + to_string(t);
+    }
+
+    // Function to pick the terminal that starts an alternative of N<i> or follows a shared
+    // prefix: a pool terminal not in taken (which it joins), else the next private one
+    string leadingTerminal(int i, int& fresh, set<string>& taken) {
+        int start = opt.terminals > 0 ? uniform_int_distribution<int>(0, opt.terminals - 1)(rng) : 0;
+        for (int n = 0; n < opt.terminals; ++n) {
+            int t = (start + n) % opt.terminals;
+            if (!taken.insert("t" + to_string(t)).second) continue;
+            pooled[i].push_back(poolTerminal(t));
+            return pooled[i].back();
+        }
+        return freshTerminal(i, fresh++);
+    }
+
+    string separator() {
+        return "s" + to_string(uniform_int_distribution<int>(0, opt.separators - 1)(rng));
+    }
+
+    int laterNonTerminal(int i) {
+        return uniform_int_distribution<int>(i + 1, opt.nonTerminals - 1)(rng);
+    }
+
+    // Function to append random symbols until rhs has `length` symbols (a non-terminal and its
+    // separator count as two); the leading terminals of the non-terminals join taken
+    void appendTail(int i, vector<string>& rhs, size_t length, set<string>& taken) {
+        while (rhs.size() < length) {
+            if (i + 1 < opt.nonTerminals && rhs.size() + 1 < length && chance(0.5)) {
+                int j = laterNonTerminal(i);
+                taken.insert(leading[j].begin(), leading[j].end());
+                rhs.push_back(name(j));
+            }
+            rhs.push_back(separator());
+        }
+    }
+
+    // Function to generate the alternatives of N<i>
+    void generateRule(int i, const vector<int>& children) {
+        vector<vector<string>>& alternatives = rules[i];
+        int count = uniform_int_distribution<int>(1, opt.alternatives)(rng);
+        int fresh = 0;
+        // pool terminals this rule must not start an alternative with: those it already did,
+        // and the leading terminals of the non-terminals it refers to
+        set<string> taken;
+        for (int child : children) taken.insert(leading[child].begin(), leading[child].end());
+
+        for (int k = 0; k < count; ++k) {
+            size_t length = (size_t)uniform_int_distribution<int>(1, opt.rhsLength)(rng);
+            vector<string> rhs;
+            if (k > 0 && chance(opt.sharedPrefix)) {
+                const vector<string>& earlier = alternatives[uniform_int_distribution<int>(0, k - 1)(rng)];
+                size_t shared = (size_t)uniform_int_distribution<int>(1, (int)earlier.size())(rng);
+                rhs.assign(earlier.begin(), earlier.begin() + shared);
+            }
+            if (rhs.empty() || rhs.back()[0] != 'N') {
+                rhs.push_back(leadingTerminal(i, fresh, taken));
+            } else {
+                // the prefix ends in N<j>, so the terminal lands in FOLLOW(N<j>) and must not
+                // continue a factored prefix of N<j> either
+                const vector<string>& inner = pooled[stoi(rhs.back().substr(1))];
+                set<string> avoid = taken;
+                avoid.insert(inner.begin(), inner.end());
+                rhs.push_back(leadingTerminal(i, fresh, avoid));
+                taken.insert(rhs.back());
+            }
+            appendTail(i, rhs, length, taken);
+            alternatives.push_back(rhs);
+        }
+        firstStart[i] = alternatives[0][0];
+
+        // attach the children to random alternatives
+        for (int child : children) {
+            vector<string>& rhs = alternatives[uniform_int_distribution<int>(0, count - 1)(rng)];
+            rhs.push_back(dead[child] == DUPLICATE_COPY ? "R" + to_string(child) : name(child));
+            rhs.push_back(separator());
+        }
+
+        if (dead[i] == NON_PRODUCTIVE) {
+            if (opt.terminals > 0) {
+                loopStart[i] = leadingTerminal(i, fresh, taken);
+            } else {
+                terminalCount++;
+                loopStart[i] = "x" + to_string(i);
+            }
+            alternatives.push_back({loopStart[i], "X" + to_string(i), separator()});
+        }
+
+        if (chance(opt.leftRecursion)) {
+            // once the recursion is eliminated the terminal can follow a factored prefix of N<i>,
+            // and start N<i> itself if it is nullable
+            string recursion;
+            if (opt.terminals > 0) {
+                recursion = leadingTerminal(i, fresh, taken);
+            } else {
+                terminalCount++;
+                recursion = "r" + to_string(i);
+            }
+            leading[i].push_back(recursion);
+            vector<string> rhs = {name(i), recursion};
+            appendTail(i, rhs, 2 + (size_t)uniform_int_distribution<int>(0, opt.rhsLength - 1)(rng), taken);
+            alternatives.push_back(rhs);
+        }
+
+        if (i + 1 < opt.nonTerminals && chance(opt.conflicts)) {
+            int j = laterNonTerminal(i);
+            if (nullable[j]) {
+                // FIRST/FOLLOW: a<j>_0 can both start N<j> and follow it
+                alternatives.push_back({leadingTerminal(i, fresh, taken), name(j), firstStart[j]});
+            } else {
+                // FIRST/FIRST: both alternatives start with a<j>_0
+                alternatives.push_back({name(j), separator()});
+                alternatives.push_back({firstStart[j], separator()});
+            }
+        }
+
+        if (chance(opt.epsilon)) {
+            alternatives.push_back({"ε"});
+            nullable[i] = true;
+        }
+
+        for (const vector<string>& rhs : alternatives) {
+            if (rhs[0] != "ε" && rhs[0][0] != 'N') leading[i].push_back(rhs[0]);
+        }
+    }
+};
+
+// Function to parse a --name=value option into value, returns false if arg is not that option
+template <typename T>
+bool parseOption(const string& arg, const string& optionName, T& value) {
+    string prefix = "--" + optionName + "=";
+    if (arg.rfind(prefix, 0) != 0) return false;
+    istringstream iss(arg.substr(prefix.size()));
+    if (!(iss >> value) || !iss.eof()) {
+        cerr << "Error: Invalid value for --" << optionName << endl;
+        exit(1);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    string outputFile;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (parseOption(arg, "nonterminals", options.nonTerminals)) continue;
+        if (parseOption(arg, "alternatives", options.alternatives)) continue;
+        if (parseOption(arg, "rhs-length", options.rhsLength)) continue;
+        if (parseOption(arg, "epsilon", options.epsilon)) continue;
+        if (parseOption(arg, "shared-prefix", options.sharedPrefix)) continue;
+        if (parseOption(arg, "left-recursion", options.leftRecursion)) continue;
+        if (parseOption(arg, "conflicts", options.conflicts)) continue;
+        if (parseOption(arg, "dead", options.dead)) continue;
+        if (parseOption(arg, "separators", options.separators)) continue;
+        if (parseOption(arg, "terminals", options.terminals)) continue;
+        if (parseOption(arg, "seed", options.seed)) continue;
+        if (arg.rfind("--output=", 0) == 0) {
+            outputFile = arg.substr(9);
+            continue;
+        }
+        cerr << "usage: " << argv[0] << " [--nonterminals=100] [--alternatives=3] [--rhs-length=4]"
+             << " [--epsilon=0.1] [--shared-prefix=0.1] [--left-recursion=0.1] [--conflicts=0] [--dead=0]"
+             << " [--separators=8] [--terminals=0] [--seed=1] [--output=FILE]" << endl;
+        cerr << "Parser handles --nonterminals=100000 with --terminals=500, but without a pool of terminals"
+             << " only up to --nonterminals=30000 and then only with --compress-table." << endl;
+        return 1;
+    }
+    if (options.nonTerminals < 1 || options.alternatives < 1 || options.rhsLength < 1 || options.separators < 1) {
+        cerr << "Error: --nonterminals, --alternatives, --rhs-length and --separators must be at least 1." << endl;
+        return 1;
+    }
+    if (options.terminals < 0) {
+        cerr << "Error: --terminals must not be negative." << endl;
+        return 1;
+    }
+
+    GrammarGenerator generator(options);
+    string grammar = generator.generate();
+
+    if (outputFile.empty()) {
+        cout << grammar;
+    } else {
+        ofstream out(outputFile);
+        if (!out) {
+            cerr << "Error: Could not open file " << outputFile << endl;
+            return 1;
+        }
+        out << grammar;
+    }
+    cerr << "Generated " << options.nonTerminals + 1 << " non-terminals, " << generator.productions()
+         << " productions, " << generator.terminals() << " terminals" << endl;
+    return 0;
+}
@@ -0,0 +1,554 @@
+//
+// Compact grammar representation the Grammar transformations work on.
+//
+// Every symbol name is interned once. A production is a span of symbol IDs in one shared
+// arena and a rule is the list of its productions' spans, so passes rewrite rules in place:
+// a suffix of an existing production is just a narrower span over the same arena words and
+// only new symbol sequences are appended. ε is not a symbol (an ε-production is an empty
+// span), and production text is never stored: it is the symbol names joined by spaces.
+//
+#ifndef ZETA_GRAMMAR_IR_H
+#define ZETA_GRAMMAR_IR_H
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <map>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+using namespace std;
+
+// Helper function to tokenize a production string into symbols
+inline vector<string> tokenizeProduction(const string& prod) {
+    vector<string> tokens;
+    // Trim leading/trailing whitespace before tokenizing
+    string trimmedProd = prod;
+    size_t first = trimmedProd.find_first_not_of(" \t");
+    if (string::npos == first) return tokens; // Empty or whitespace only
+    size_t last = trimmedProd.find_last_not_of(" \t");
+    trimmedProd = trimmedProd.substr(first, (last - first + 1));
+
+    istringstream iss(trimmedProd);
+    string token;
+    while (iss >> token) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// Helper function to join tokens back into a string
+inline string joinTokens(const vector<string>& tokens, size_t start = 0, size_t end = string::npos) {
+    string result = "";
+    if (end == string::npos) {
+        end = tokens.size();
+    }
+    for (size_t i = start; i < end; ++i) {
+        if (i > start) {
+            result += " ";
+        }
+        result += tokens[i];
+    }
+    return result;
+}
+
+// Maps every grammar symbol to a dense integer ID and back
+class SymbolInterner {
+public:
+    // returns the ID of name, assigning the next free ID if it has not been seen yet
+    int intern(const string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        int id = (int)names.size();
+        ids.emplace(name, id);
+        names.push_back(name);
+        return id;
+    }
+
+    // returns the ID of name, or -1 if it was never interned
+    int lookup(const string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    const string& name(int id) const { return names[id]; }
+    int size() const { return (int)names.size(); }
+
+    void clear() {
+        ids.clear();
+        names.clear();
+    }
+
+private:
+    unordered_map<string, int> ids;
+    vector<string> names;
+};
+
+// Production body: arena[offset, offset + length)
+struct IRSpan {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Size of a grammar, as reported per pass
+struct IRSize {
+    size_t rules = 0;
+    size_t productions = 0;
+    size_t symbols = 0;
+    size_t arenaWords = 0;
+};
+
+class GrammarIR {
+public:
+    SymbolInterner names;               // every symbol seen so far
+    vector<int> arena;                  // symbol IDs of all production bodies
+    vector<vector<IRSpan>> rules;       // productions by symbol ID; none for terminals
+
+    // Function to get the ID of a symbol, interning it if needed
+    int symbol(const string& name) {
+        int id = names.intern(name);
+        if ((size_t)id >= rules.size()) rules.resize(id + 1);
+        return id;
+    }
+
+    bool isNonTerminal(int id) const { return id >= 0 && (size_t)id < rules.size() && !rules[id].empty(); }
+
+    // Function to append a new production body made of prefix followed by symbols
+    IRSpan append(IRSpan prefix, const vector<int>& symbols = {}) {
+        IRSpan span = {(uint32_t)arena.size(), prefix.length + (uint32_t)symbols.size()};
+        arena.reserve(arena.size() + span.length);
+        for (uint32_t i = 0; i < prefix.length; ++i) arena.push_back(arena[prefix.offset + i]);
+        arena.insert(arena.end(), symbols.begin(), symbols.end());
+        return span;
+    }
+
+    const int* begin(IRSpan span) const { return arena.data() + span.offset; }
+    const int* end(IRSpan span) const { return arena.data() + span.offset + span.length; }
+
+    // Function to render a production body: names joined by spaces, "ε" if empty
+    string text(IRSpan span) const {
+        if (span.length == 0) return "ε";
+        string result;
+        for (const int* it = begin(span); it != end(span); ++it) {
+            if (it != begin(span)) result += " ";
+            result += names.name(*it);
+        }
+        return result;
+    }
+
+    // Non-terminal IDs in name order (the order rules are printed and numbered in)
+    vector<int> nonTerminalsByName() const {
+        vector<int> ids;
+        for (size_t id = 0; id < rules.size(); ++id) {
+            if (!rules[id].empty()) ids.push_back((int)id);
+        }
+        sort(ids.begin(), ids.end(), [this](int a, int b) { return names.name(a) < names.name(b); });
+        return ids;
+    }
+
+    // Start symbol: "P" if it has rules, otherwise the first non-terminal by name (-1 if none)
+    int startSymbol() const {
+        int start = names.lookup("P");
+        if (isNonTerminal(start)) return start;
+        vector<int> ids = nonTerminalsByName();
+        return ids.empty() ? -1 : ids[0];
+    }
+
+    IRSize size() const {
+        IRSize s;
+        for (const vector<IRSpan>& productions : rules) {
+            if (productions.empty()) continue;
+            s.rules++;
+            s.productions += productions.size();
+        }
+        s.symbols = (size_t)names.size();
+        s.arenaWords = arena.size();
+        return s;
+    }
+
+    // Function to drop arena words no production refers to any more (rules keep their order)
+    void compact() {
+        vector<int> live;
+        live.reserve(arena.size());
+        for (vector<IRSpan>& productions : rules) {
+            for (IRSpan& span : productions) {
+                uint32_t offset = (uint32_t)live.size();
+                live.insert(live.end(), begin(span), end(span));
+                span.offset = offset;
+            }
+        }
+        arena = std::move(live);
+    }
+};
+
+// Node of the token trie that left factoring builds over the alternatives of one rule
+struct FactorNode {
+    unordered_map<int, int> children;        // symbol ID -> node
+    vector<int> branches;                    // children in order of appearance
+    uint32_t depth = 0;                      // symbols from the root
+    int alternatives = 0;                    // alternatives passing through this node
+    int firstAlternative = -1;               // first of them
+    int endAlternative = -1;                 // first alternative ending here, if any
+};
+
+// Function to emit the alternatives below a trie node as productions of `name`. Unshared
+// alternatives at the root keep their span; a branching node gets a new non-terminal.
+inline void emitFactored(GrammarIR& ir, const vector<FactorNode>& trie, int node, const string& name,
+                         const vector<IRSpan>& originals, vector<IRSpan>& alternatives, int& newSymbolCount) {
+    // branches in the order their first alternative appeared; the alternative ending here is one of them
+    vector<int> branches = trie[node].branches;
+    auto firstOf = [&trie](int branch) { return branch < 0 ? trie[-branch - 1].endAlternative : trie[branch].firstAlternative; };
+    if (trie[node].endAlternative >= 0) {
+        branches.push_back(-node - 1);
+        stable_sort(branches.begin(), branches.end(), [&](int a, int b) { return firstOf(a) < firstOf(b); });
+    }
+
+    for (int branch : branches) {
+        if (branch < 0) {
+            alternatives.push_back(node == 0 ? originals[trie[node].endAlternative] : IRSpan{0, 0});
+            continue;
+        }
+        const IRSpan& first = originals[trie[branch].firstAlternative];
+        if (node == 0 && trie[branch].alternatives == 1) {
+            alternatives.push_back(first);
+            continue;
+        }
+
+        // follow the path while nothing branches off it
+        int end = branch;
+        while (trie[end].endAlternative < 0 && trie[end].branches.size() == 1) end = trie[end].branches[0];
+        uint32_t from = trie[node].depth;
+        if (trie[end].branches.empty()) {
+            // the rest of the first alternative through here, without copying it
+            alternatives.push_back({first.offset + from, first.length - from});
+            continue;
+        }
+
+        string newNonTerminal;
+        do newNonTerminal = name + "_" + to_string(++newSymbolCount);
+        while (ir.names.lookup(newNonTerminal) >= 0);
+        int newId = ir.symbol(newNonTerminal);
+        alternatives.push_back(ir.append({first.offset + from, trie[end].depth - from}, {newId}));
+        vector<IRSpan> suffixes;
+        emitFactored(ir, trie, end, newNonTerminal, originals, suffixes, newSymbolCount);
+        ir.rules[newId] = std::move(suffixes);
+    }
+}
+
+// Left factoring: the alternatives of each rule go into a token trie once; every node where
+// alternatives part ways (or one of them ends) becomes a new non-terminal lhs_N holding the
+// suffixes, so nested common prefixes are factored in the same pass.
+inline int factorLeft(GrammarIR& ir) {
+    int newSymbolCount = 0;
+    for (int lhs : ir.nonTerminalsByName()) {
+        vector<IRSpan> productions = std::move(ir.rules[lhs]);
+        vector<FactorNode> trie(1);
+        for (size_t p = 0; p < productions.size(); ++p) {
+            int node = 0;
+            trie[0].alternatives++;
+            for (const int* it = ir.begin(productions[p]); it != ir.end(productions[p]); ++it) {
+                auto found = trie[node].children.find(*it);
+                int child;
+                if (found == trie[node].children.end()) {
+                    child = (int)trie.size();
+                    trie[node].children.emplace(*it, child);
+                    trie[node].branches.push_back(child);
+                    trie.emplace_back();
+                    trie[child].depth = trie[node].depth + 1;
+                    trie[child].firstAlternative = (int)p;
+                } else {
+                    child = found->second;
+                }
+                node = child;
+                trie[node].alternatives++;
+            }
+            if (trie[node].endAlternative < 0) trie[node].endAlternative = (int)p;
+        }
+        vector<IRSpan> factored;
+        emitFactored(ir, trie, 0, ir.names.name(lhs), productions, factored, newSymbolCount);
+        ir.rules[lhs] = std::move(factored);
+    }
+    return 1;
+}
+
+// Immediate left recursion elimination: A -> A α | β becomes A -> β A' and A' -> α A' | ε
+inline int eliminateLeftRecursion(GrammarIR& ir) {
+    for (int lhs : ir.nonTerminalsByName()) {
+        vector<IRSpan> alphas, betas;
+        for (const IRSpan& span : ir.rules[lhs]) {
+            if (span.length > 0 && ir.arena[span.offset] == lhs) alphas.push_back({span.offset + 1, span.length - 1});
+            else betas.push_back(span);
+        }
+        if (alphas.empty()) continue;
+
+        string newNonTerminal = ir.names.name(lhs) + "'";
+        while (ir.isNonTerminal(ir.names.lookup(newNonTerminal))) newNonTerminal += "'";
+        int newId = ir.symbol(newNonTerminal);
+
+        // an empty β (none left, or an ε alternative) becomes A -> A'
+        if (betas.empty()) betas.push_back({0, 0});
+        vector<IRSpan> lhsProds, newProds;
+        for (const IRSpan& beta : betas) lhsProds.push_back(ir.append(beta, {newId}));
+        for (const IRSpan& alpha : alphas) newProds.push_back(ir.append(alpha, {newId}));
+        newProds.push_back({0, 0});
+        ir.rules[lhs] = std::move(lhsProds);
+        ir.rules[newId] = std::move(newProds);
+    }
+    return 1;
+}
+
+// What reduceGrammar removed, by name
+struct GrammarReduction {
+    vector<string> nonProductive;            // derive no terminal string
+    vector<string> unreachable;              // not used from the start symbol
+    vector<pair<string, string>> merged;     // (removed, kept) with identical rules
+    size_t duplicateProductions = 0;         // alternatives that became identical after merging
+};
+
+// Function to drop non-terminals that derive no terminal string, with every production using one
+inline void removeNonProductive(GrammarIR& ir, GrammarReduction& report) {
+    // pending[p]: non-terminals in production p not known to be productive yet
+    vector<int> productionLhs;
+    vector<int> pending;
+    vector<vector<int>> users(ir.rules.size());
+    vector<char> productive(ir.rules.size(), 0);
+    vector<int> worklist;
+    for (size_t id = 0; id < ir.rules.size(); ++id) {
+        if (!ir.isNonTerminal((int)id)) productive[id] = 1;
+        for (const IRSpan& span : ir.rules[id]) {
+            int p = (int)productionLhs.size();
+            productionLhs.push_back((int)id);
+            int count = 0;
+            for (const int* it = ir.begin(span); it != ir.end(span); ++it) {
+                if (ir.isNonTerminal(*it)) {
+                    users[*it].push_back(p);
+                    count++;
+                }
+            }
+            pending.push_back(count);
+            if (count == 0) worklist.push_back(p);
+        }
+    }
+    while (!worklist.empty()) {
+        int lhs = productionLhs[worklist.back()];
+        worklist.pop_back();
+        if (productive[lhs]) continue;
+        productive[lhs] = 1;
+        for (int p : users[lhs]) {
+            if (--pending[p] == 0) worklist.push_back(p);
+        }
+    }
+
+    for (int lhs : ir.nonTerminalsByName()) {
+        if (!productive[lhs]) {
+            report.nonProductive.push_back(ir.names.name(lhs));
+            ir.rules[lhs].clear();
+            continue;
+        }
+        vector<IRSpan>& spans = ir.rules[lhs];
+        spans.erase(remove_if(spans.begin(), spans.end(), [&](const IRSpan& span) {
+            return any_of(ir.begin(span), ir.end(span), [&](int symbol) { return !productive[symbol]; });
+        }), spans.end());
+    }
+}
+
+// Function to drop non-terminals the start symbol never reaches
+inline void removeUnreachable(GrammarIR& ir, GrammarReduction& report) {
+    int start = ir.startSymbol();
+    vector<char> reached(ir.rules.size(), 0);
+    vector<int> worklist;
+    if (start >= 0) {
+        reached[start] = 1;
+        worklist.push_back(start);
+    }
+    while (!worklist.empty()) {
+        int lhs = worklist.back();
+        worklist.pop_back();
+        for (const IRSpan& span : ir.rules[lhs]) {
+            for (const int* it = ir.begin(span); it != ir.end(span); ++it) {
+                if (!reached[*it] && ir.isNonTerminal(*it)) {
+                    reached[*it] = 1;
+                    worklist.push_back(*it);
+                }
+            }
+        }
+    }
+
+    for (int lhs : ir.nonTerminalsByName()) {
+        if (reached[lhs]) continue;
+        report.unreachable.push_back(ir.names.name(lhs));
+        ir.rules[lhs].clear();
+    }
+}
+
+// Function to merge non-terminals whose rules are the same up to renaming of merged symbols.
+// As in DFA minimization, all non-terminals start in one block that is split by the sorted
+// productions (non-terminals written as their block) until no block splits; each block then
+// keeps one member, the start symbol if it is there and otherwise the first name.
+inline void mergeIdenticalRules(GrammarIR& ir, GrammarReduction& report) {
+    vector<int> nonTerminals = ir.nonTerminalsByName();
+    vector<int> block(ir.rules.size(), -1);
+    for (int lhs : nonTerminals) block[lhs] = 0;
+
+    size_t blocks = 1;
+    while (true) {
+        map<vector<int>, int> signatures;
+        vector<int> next(ir.rules.size(), -1);
+        for (int lhs : nonTerminals) {
+            // terminals as their ID, non-terminals as -(block + 1)
+            vector<vector<int>> bodies;
+            for (const IRSpan& span : ir.rules[lhs]) {
+                vector<int> body;
+                for (const int* it = ir.begin(span); it != ir.end(span); ++it) body.push_back(block[*it] >= 0 ? -block[*it] - 1 : *it);
+                bodies.push_back(std::move(body));
+            }
+            sort(bodies.begin(), bodies.end());
+            bodies.erase(unique(bodies.begin(), bodies.end()), bodies.end());
+
+            vector<int> signature = {block[lhs]};
+            for (const vector<int>& body : bodies) {
+                signature.push_back((int)body.size());
+                signature.insert(signature.end(), body.begin(), body.end());
+            }
+            next[lhs] = signatures.emplace(std::move(signature), (int)signatures.size()).first->second;
+        }
+        block = std::move(next);
+        if (signatures.size() == blocks) break;
+        blocks = signatures.size();
+    }
+
+    int start = ir.startSymbol();
+    vector<int> keeper(blocks, -1);
+    if (start >= 0) keeper[block[start]] = start;
+    for (int lhs : nonTerminals) {
+        if (keeper[block[lhs]] < 0) keeper[block[lhs]] = lhs;
+    }
+    vector<int> replacement(ir.rules.size());
+    for (size_t id = 0; id < ir.rules.size(); ++id) replacement[id] = block[id] >= 0 ? keeper[block[id]] : (int)id;
+
+    for (int lhs : nonTerminals) {
+        if (replacement[lhs] == lhs) continue;
+        report.merged.push_back({ir.names.name(lhs), ir.names.name(replacement[lhs])});
+        ir.rules[lhs].clear();
+    }
+    if (report.merged.empty()) return;
+
+    // rename in place (spans may share words; renaming twice is harmless), then drop
+    // alternatives of a rule that became identical
+    for (int lhs : nonTerminals) {
+        vector<IRSpan>& spans = ir.rules[lhs];
+        for (const IRSpan& span : spans) {
+            for (uint32_t i = 0; i < span.length; ++i) ir.arena[span.offset + i] = replacement[ir.arena[span.offset + i]];
+        }
+        vector<IRSpan> distinct;
+        for (const IRSpan& span : spans) {
+            bool seen = any_of(distinct.begin(), distinct.end(), [&](const IRSpan& other) {
+                return equal(ir.begin(span), ir.end(span), ir.begin(other), ir.end(other));
+            });
+            if (seen) report.duplicateProductions++;
+            else distinct.push_back(span);
+        }
+        spans = std::move(distinct);
+    }
+}
+
+// Grammar reduction: non-productive symbols first (dropping their productions can cut the
+// only path to a rule), then unreachable ones, then identical rules
+inline int reduceGrammar(GrammarIR& ir, GrammarReduction& report) {
+    report = GrammarReduction();
+    removeNonProductive(ir, report);
+    removeUnreachable(ir, report);
+    mergeIdenticalRules(ir, report);
+    return 1;
+}
+
+// Function to print what reduceGrammar removed
+inline void printReduction(ostream& out, const GrammarReduction& report) {
+    auto printNames = [&out](const string& title, const vector<string>& names) {
+        out << title << " (" << names.size() << ")";
+        for (size_t i = 0; i < names.size(); ++i) out << (i ? ", " : ": ") << names[i];
+        out << endl;
+    };
+    printNames("Non-productive non-terminals removed", report.nonProductive);
+    printNames("Unreachable non-terminals removed", report.unreachable);
+    out << "Identical non-terminals merged (" << report.merged.size() << ")";
+    for (size_t i = 0; i < report.merged.size(); ++i) {
+        out << (i ? ", " : ": ") << report.merged[i].first << " into " << report.merged[i].second;
+    }
+    out << endl;
+    if (report.duplicateProductions) out << "Duplicate productions removed after merging: " << report.duplicateProductions << endl;
+}
+
+// Runs transformations over a GrammarIR in order. Every pass rewrites the IR in place (nothing
+// is copied between passes); the manager times each one and records how the grammar changed.
+class PassManager {
+public:
+    typedef function<int(GrammarIR&)> Pass;
+
+    struct PassResult {
+        string name;
+        double ms = 0;
+        IRSize before, after;
+    };
+
+    PassManager() = default;
+    PassManager(const PassManager&) = delete;
+    PassManager& operator=(const PassManager&) = delete;
+    PassManager(PassManager&&) = default;
+    PassManager& operator=(PassManager&&) = default;
+
+    void add(const string& name, Pass pass) { passes.push_back({name, std::move(pass)}); }
+
+    // Function to run the passes; afterPass (if set) sees the IR after each one.
+    // Stops at the first pass that returns 0 and reports failure.
+    bool run(GrammarIR& ir, const function<void(const string&)>& afterPass = nullptr) {
+        results.clear();
+        for (auto& [name, pass] : passes) {
+            PassResult result;
+            result.name = name;
+            result.before = ir.size();
+            auto start = chrono::steady_clock::now();
+            int status = pass(ir);
+            result.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            result.after = ir.size();
+            results.push_back(result);
+            if (!status) return false;
+            if (afterPass) afterPass(name);
+        }
+        return true;
+    }
+
+    const vector<PassResult>& lastResults() const { return results; }
+
+    // Function to print the time and size change of every pass of the last run
+    void printReport(ostream& out) const {
+        auto delta = [](size_t before, size_t after) {
+            char buffer[48];
+            snprintf(buffer, sizeof(buffer), "%zu (%+lld)", after, (long long)after - (long long)before);
+            return string(buffer);
+        };
+        out << left << setw(28) << "Pass" << setw(12) << "Time (ms)" << setw(16) << "Rules" << setw(16) << "Productions"
+            << setw(16) << "Symbols" << "Arena words" << endl;
+        for (const PassResult& r : results) {
+            char ms[32];
+            snprintf(ms, sizeof(ms), "%.3f", r.ms);
+            out << setw(28) << r.name << setw(12) << ms << setw(16) << delta(r.before.rules, r.after.rules)
+                << setw(16) << delta(r.before.productions, r.after.productions)
+                << setw(16) << delta(r.before.symbols, r.after.symbols)
+                << delta(r.before.arenaWords, r.after.arenaWords) << endl;
+        }
+        out << right;
+    }
+
+private:
+    vector<pair<string, Pass>> passes;
+    vector<PassResult> results;
+};
+
+#endif // ZETA_GRAMMAR_IR_H
@@ -0,0 +1,945 @@
+//
+// Created by Ali Hamza Azam on 25/04/2025.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <new>
+#include <unordered_map>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "ParseDriver.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define INPUT_CHUNK_SIZE (1024 * 1024)            // read size for streamed input
+#define INPUT_RELEASE_SIZE (64 * 1024 * 1024)     // consumed mapped input dropped in steps of this
+#define TRACE_RING_SIZE 65536             // step records kept in memory (power of two)
+#define BATCH_CHUNK_SIZE (256 * 1024)       // input bytes per batch work item (rounded up to a whole line)
+
+// Point the table at a validated image
+void attach_parsing_table(ParsingTable *table, const void *data) {
+    const ZLL1Header *h = (const ZLL1Header *)data;
+    table->header = h;
+    table->symbols = zll1_symbols(h);
+    table->strings = zll1_strings(h);
+    table->actions = zll1_actions(h);
+    table->comb = NULL;
+    if (h->flags & ZLL1_FLAG_COMPRESSED_ACTIONS) {
+        table->actions = NULL;
+        table->comb = zll1_comb(h);
+        table->row_of = zll1_row_of(h);
+        table->row_base = zll1_row_base(h);
+        table->row_defaults = zll1_row_defaults(h);
+    }
+    table->productions = zll1_productions(h);
+    table->rhs = zll1_rhs(h);
+    table->num_terminals = (int)h->num_terminals;
+    table->num_nonterminals = (int)(h->num_symbols - h->num_terminals);
+    table->end_marker = zll1_find_symbol(h, "$", 1);
+}
+
+// Look up the ID of a symbol, or -1 if the table does not know it
+int lookup_symbol(const ParsingTable *table, std::string_view symbol) {
+    return zll1_find_symbol(table->header, symbol.data(), symbol.size());
+}
+
+// Name of a symbol ID
+const char* symbol_name(const ParsingTable *table, int id) {
+    return table->strings + table->symbols[id].name_offset;
+}
+
+// Heap allocations of the current thread; see AllocationCount.cpp
+thread_local size_t allocation_count = 0;
+
+// Allocate bytes (8-byte aligned) from the arena
+void* arena_alloc(Arena *a, size_t bytes) {
+    bytes = (bytes + 7) & ~(size_t)7;
+    while (a->current == NULL || a->used + bytes > a->current->size) {
+        // move on to the next kept block, or add one big enough
+        ArenaBlock *next = a->current ? a->current->next : a->first;
+        if (next == NULL || next->size < bytes) {
+            size_t size = bytes > ARENA_BLOCK_SIZE ? bytes : ARENA_BLOCK_SIZE;
+            ArenaBlock *block = (ArenaBlock *)::operator new(sizeof(ArenaBlock) + size, std::nothrow);
+            if (!block) {
+                fprintf(stderr, "Out of memory!\n");
+                exit(EXIT_FAILURE);
+            }
+            block->size = size;
+            block->next = next;
+            if (a->current) a->current->next = block;
+            else a->first = block;
+            next = block;
+        }
+        a->current = next;
+        a->used = 0;
+    }
+    void *p = (char *)(a->current + 1) + a->used;
+    a->used += bytes;
+    return p;
+}
+
+// Release everything allocated since the last reset, keeping the blocks
+void arena_reset(Arena *a) {
+    a->current = a->first;
+    a->used = 0;
+}
+
+// Return all blocks to the heap
+void arena_free(Arena *a) {
+    ArenaBlock *block = a->first;
+    while (block) {
+        ArenaBlock *next = block->next;
+        ::operator delete(block);
+        block = next;
+    }
+    a->first = a->current = NULL;
+    a->used = 0;
+}
+
+// Initialize stack with start symbol and $
+void stack_init(Stack *s, Arena *arena, const ParsingTable *table, int start_symbol) {
+    s->items = s->inline_items;
+    s->capacity = STACK_INLINE_SIZE;
+    s->arena = arena;
+    s->top = -1;
+    s->items[++s->top] = table->end_marker;
+    s->items[++s->top] = start_symbol;
+}
+
+// Make room for at least needed symbols (amortized doubling)
+void stack_reserve(Stack *s, size_t needed) {
+    if (needed <= (size_t)s->capacity) return;
+    size_t capacity = (size_t)s->capacity * 2;
+    while (capacity < needed) capacity *= 2;
+    if (capacity > INT32_MAX) {
+        fprintf(stderr, "Stack overflow!\n");
+        exit(EXIT_FAILURE);
+    }
+    int32_t *items = (int32_t *)arena_alloc(s->arena, capacity * sizeof(int32_t));
+    memcpy(items, s->items, (size_t)(s->top + 1) * sizeof(int32_t));
+    s->items = items;
+    s->capacity = (int)capacity;
+}
+
+// Push a production's RHS, already stored in reverse order, with a single copy
+void stack_push_rhs(Stack *s, const int32_t *reversed_rhs, uint32_t length) {
+    stack_reserve(s, (size_t)s->top + 1 + length);
+    memcpy(&s->items[s->top + 1], reversed_rhs, length * sizeof(int32_t));
+    s->top += (int)length;
+}
+
+// Pop a symbol from the stack
+int stack_pop(Stack *s) {
+    if (s->top < 0) {
+        fprintf(stderr, "Stack underflow!\n");
+        exit(EXIT_FAILURE);
+    }
+    return s->items[s->top--];
+}
+
+// Peek at the top of the stack (-1 if empty)
+int stack_peek(Stack *s) {
+    return (s->top >= 0) ? s->items[s->top] : -1;
+}
+
+// Load parsing table from a CSV file
+void load_parsing_table(ParsingTable *table, const char *filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        perror("Error opening parsing table file");
+        exit(EXIT_FAILURE);
+    }
+
+    std::string line;
+    bool header_read = false;
+
+    // Symbols get IDs in order of appearance: header terminals first, then row non-terminals
+    std::vector<std::string> symbol_names;
+    std::unordered_map<std::string, int> symbol_ids;
+    auto intern_symbol = [&](const std::string &symbol) {
+        auto it = symbol_ids.find(symbol);
+        if (it != symbol_ids.end()) return it->second;
+        int id = (int)symbol_names.size();
+        symbol_ids.emplace(symbol, id);
+        symbol_names.push_back(symbol);
+        return id;
+    };
+    int num_terminals = 0;
+
+    // Cells are collected first because the number of rows is only known at the end
+    struct Cell { int row; int column; int production; };
+    std::vector<Cell> cells;
+    std::vector<ZLL1SourceProduction> productions;
+    std::unordered_map<std::string, int> production_ids; // "lhs\0rhs" -> production index
+
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string segment;
+        std::vector<std::string> segments;
+
+        while (std::getline(ss, segment, ',')) {
+            // Trim leading/trailing whitespace if necessary (basic trim)
+            segment.erase(0, segment.find_first_not_of(" \t\n\r\f\v"));
+            segment.erase(segment.find_last_not_of(" \t\n\r\f\v") + 1);
+            segments.push_back(segment);
+        }
+
+        if (segments.empty()) continue; // Skip empty lines
+
+        if (!header_read) {
+            // Read header: first segment is "Non-Terminal", skip it
+            for (size_t i = 1; i < segments.size(); ++i) {
+                intern_symbol(segments[i]);
+            }
+            num_terminals = (int)symbol_names.size();
+            header_read = true;
+        } else {
+            // Read data row
+            if (segments.size() < 1) continue; // Malformed row
+            std::string non_terminal = segments[0];
+            int lhs = intern_symbol(non_terminal);
+            int row = lhs - num_terminals;
+            if (row < 0) {
+                fprintf(stderr, "Error: Non-terminal '%s' is also a terminal\n", non_terminal.c_str());
+                exit(EXIT_FAILURE);
+            }
+
+            for (size_t i = 1; i < segments.size(); ++i) {
+                if (i - 1 < (size_t)num_terminals && !segments[i].empty()) {
+                    std::string production_full = segments[i]; // e.g., " E → T E'"
+                    std::string production_rhs;
+
+                    // Find the arrow '→' or '->'
+                    size_t arrow_pos = production_full.find("→");
+                    std::string arrow_str = "→";
+                    size_t arrow_len = std::string(arrow_str).length(); // Get length of arrow string
+
+                    if (arrow_pos == std::string::npos) {
+                         arrow_pos = production_full.find("->");
+                         arrow_str = "->";
+                         arrow_len = std::string(arrow_str).length(); // Get length of arrow string
+                    }
+
+                    if (arrow_pos != std::string::npos) {
+                        // Extract substring AFTER the arrow
+                        if (arrow_pos + arrow_len < production_full.length()) {
+                            production_rhs = production_full.substr(arrow_pos + arrow_len);
+                        } else {
+                            // Arrow is at the very end, means epsilon
+                            production_rhs = "ε";
+                        }
+                    } else if (production_full == "ε") {
+                        production_rhs = "ε"; // Handle epsilon explicitly if no arrow
+                    } else {
+                         // No arrow found, and not epsilon. Assume the segment IS the RHS.
+                         production_rhs = production_full;
+                         // Optional: Add warning if format strictly requires an arrow
+                         // fprintf(stderr, "Warning: No arrow found in production '%s'. Assuming it's the RHS.\n", production_full.c_str());
+                    }
+
+                    // Trim leading/trailing whitespace from the extracted RHS
+                    production_rhs.erase(0, production_rhs.find_first_not_of(" \t\n\r\f\v"));
+                    production_rhs.erase(production_rhs.find_last_not_of(" \t\n\r\f\v") + 1);
+
+                    // Ensure RHS is not empty after trimming, default to epsilon if it is
+                    // (unless the original segment was already epsilon)
+                    if (production_rhs.empty() && production_full != "ε") {
+                         production_rhs = "ε";
+                    }
+
+                    // Store each distinct production once and remember the cell
+                    std::string key = non_terminal + '\0' + production_rhs;
+                    auto found = production_ids.find(key);
+                    int production = (int)productions.size();
+                    if (found == production_ids.end()) {
+                        production_ids.emplace(key, production);
+                        productions.push_back({lhs, {}, production_rhs});
+                    } else {
+                        production = found->second;
+                    }
+                    cells.push_back({row, (int)(i - 1), production});
+                }
+            }
+        }
+    }
+
+    if (!header_read) {
+         fprintf(stderr, "Error: Could not read header from parsing table file.\n");
+         exit(EXIT_FAILURE);
+    }
+    if (cells.empty()) {
+        fprintf(stderr, "Warning: No entries loaded from parsing table.\n");
+    }
+
+    // Split every RHS into symbol IDs now that every row is known
+    // (a symbol that is neither a column nor a row becomes a non-terminal without entries)
+    for (ZLL1SourceProduction &production : productions) {
+        std::stringstream rhs_ss(production.text);
+        std::string symbol;
+        while (rhs_ss >> symbol) {
+            if (symbol != "ε") production.rhs.push_back(intern_symbol(symbol));
+        }
+    }
+
+    // Start symbol: P as in Parser.cpp, otherwise the first row
+    int start_symbol = symbol_ids.count("P") ? symbol_ids["P"] : num_terminals;
+    if (start_symbol < num_terminals || start_symbol >= (int)symbol_names.size()) {
+        fprintf(stderr, "Error: Parsing table has no non-terminal rows.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Build the dense table and lay it out like the binary format
+    int num_nonterminals = (int)symbol_names.size() - num_terminals;
+    std::vector<int32_t> actions((size_t)num_nonterminals * num_terminals, NO_PRODUCTION);
+    for (const Cell &cell : cells) {
+        actions[(size_t)cell.row * num_terminals + cell.column] = cell.production;
+    }
+    table->image = zll1_build(symbol_names, num_terminals, start_symbol, productions, actions);
+    attach_parsing_table(table, table->image.data());
+}
+
+// Map a compiled table produced by Parser.cpp and use it in place.
+// Returns false if the file does not exist; a file that exists but is invalid is fatal.
+bool load_parsing_table_binary(ParsingTable *table, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("Error reading compiled parsing table");
+        exit(EXIT_FAILURE);
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("Error mapping compiled parsing table");
+        exit(EXIT_FAILURE);
+    }
+
+    const char *error = NULL;
+    if (!zll1_validate(data, (size_t)st.st_size, &error)) {
+        fprintf(stderr, "Error: %s: %s\n", filename, error);
+        exit(EXIT_FAILURE);
+    }
+    table->mapping = data;
+    table->mapping_size = (size_t)st.st_size;
+    attach_parsing_table(table, data);
+    return true;
+}
+
+// Use a table image that lives elsewhere (e.g. built into the binary by ConstexprGrammar.h).
+// The image is validated but neither copied nor owned.
+void load_parsing_table_image(ParsingTable *table, const void *data, size_t size) {
+    const char *error = NULL;
+    if (!zll1_validate(data, size, &error)) {
+        fprintf(stderr, "Error: built-in parsing table: %s\n", error);
+        exit(EXIT_FAILURE);
+    }
+    attach_parsing_table(table, data);
+}
+
+// Release the mapping or image behind the table
+void unload_parsing_table(ParsingTable *table) {
+    if (table->mapping) munmap(table->mapping, table->mapping_size);
+    table->mapping = NULL;
+    table->image.clear();
+    table->header = NULL;
+}
+
+static bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Map a whole input file. Returns false if it cannot be opened.
+bool reader_open_file(TokenReader *r, const char *filename) {
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+        r->mapping = (const char *)data;
+        r->mapping_size = (size_t)st.st_size;
+        r->pos = r->released = r->mapping;
+        r->end = r->mapping + r->mapping_size;
+    }
+    close(fd);
+    return true;
+}
+
+// Read from fd (e.g. stdin) in chunks of INPUT_CHUNK_SIZE
+void reader_open_stream(TokenReader *r, int fd) {
+    memset(r, 0, sizeof(*r));
+    r->fd = fd;
+    r->capacity = INPUT_CHUNK_SIZE;
+    r->buffer = (char *)malloc(r->capacity);
+    if (!r->buffer) {
+        fprintf(stderr, "Out of memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    r->pos = r->end = r->buffer;
+}
+
+// Read the lines in [begin, end) of memory owned by the caller, numbering them from
+// first_line + 1. Used by batch mode for one chunk of a mapped file.
+void reader_open_range(TokenReader *r, const char *begin, const char *end, size_t first_line) {
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+    r->pos = begin;
+    r->end = end;
+    r->line_number = first_line;
+    r->eof = true;
+}
+
+void reader_close(TokenReader *r) {
+    if (r->mapping) munmap((void *)r->mapping, r->mapping_size);
+    free(r->buffer);
+    memset(r, 0, sizeof(*r));
+}
+
+// Stream mode: read the next chunk, keeping [*keep, end) at the front of the buffer
+// (the buffer only grows when a single token fills it). Returns false at end of input.
+static bool reader_refill(TokenReader *r, const char **keep) {
+    if (r->mapping || r->buffer == NULL || r->eof) return false;
+
+    size_t kept = (size_t)(r->end - *keep);
+    size_t pos_offset = (size_t)(r->pos - *keep);
+    if (kept == r->capacity) {
+        char *grown = (char *)malloc(r->capacity * 2);
+        if (!grown) {
+            fprintf(stderr, "Out of memory!\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(grown, *keep, kept);
+        free(r->buffer);
+        r->buffer = grown;
+        r->capacity *= 2;
+    } else {
+        memmove(r->buffer, *keep, kept);
+    }
+    *keep = r->buffer;
+    r->pos = r->buffer + pos_offset;
+    r->end = r->buffer + kept;
+
+    ssize_t n;
+    do {
+        n = read(r->fd, r->buffer + kept, r->capacity - kept);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        if (n < 0) perror("Error reading input");
+        r->eof = true;
+        return false;
+    }
+    r->end += n;
+    return true;
+}
+
+// mmap mode: drop pages that were fully consumed so resident memory stays flat
+static void reader_release_consumed(TokenReader *r) {
+    if (!r->mapping || (size_t)(r->pos - r->released) < INPUT_RELEASE_SIZE) return;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const char *upto = r->mapping + ((size_t)(r->pos - r->mapping) & ~(page - 1));
+    if (upto > r->released) {
+        madvise((void *)r->released, (size_t)(upto - r->released), MADV_DONTNEED);
+        r->released = upto;
+    }
+}
+
+// Move to the start of the next non-empty line. Returns false at end of input.
+bool reader_next_line(TokenReader *r) {
+    // skip whatever the driver left of the previous line
+    if (r->in_line) {
+        for (;;) {
+            const char *newline = (const char *)memchr(r->pos, '\n', (size_t)(r->end - r->pos));
+            if (newline) {
+                r->pos = newline + 1;
+                break;
+            }
+            r->pos = r->end;
+            const char *keep = r->end;
+            if (!reader_refill(r, &keep)) break;
+        }
+        r->in_line = false;
+    }
+
+    for (;;) {
+        if (r->pos == r->end) {
+            const char *keep = r->end;
+            if (!reader_refill(r, &keep)) return false;
+            continue;
+        }
+        r->line_number++;
+        if (*r->pos != '\n') break;
+        r->pos++; // empty line
+    }
+
+    r->in_line = true;
+    reader_release_consumed(r);
+    return true;
+}
+
+// Next token of the current line. Returns false at the end of the line.
+bool reader_next_token(TokenReader *r, std::string_view *token) {
+    for (;;) {
+        while (r->pos < r->end && is_separator(*r->pos)) r->pos++;
+        if (r->pos == r->end) {
+            const char *keep = r->end;
+            if (!reader_refill(r, &keep)) return false;
+            continue;
+        }
+        if (*r->pos == '\n') return false;
+
+        const char *start = r->pos;
+        for (;;) {
+            while (r->pos < r->end && !is_separator(*r->pos) && *r->pos != '\n') r->pos++;
+            // a token cut off by the end of the chunk continues in the next one
+            if (r->pos < r->end || !reader_refill(r, &start)) break;
+        }
+        *token = std::string_view(start, (size_t)(r->pos - start));
+        return true;
+    }
+}
+
+// The rest of the current line, if it is entirely in memory (always true for a mapped file)
+bool reader_line_view(TokenReader *r, std::string_view *line) {
+    for (;;) {
+        const char *newline = (const char *)memchr(r->pos, '\n', (size_t)(r->end - r->pos));
+        if (newline || r->mapping || r->eof) {
+            const char *line_end = newline ? newline : r->end;
+            *line = std::string_view(r->pos, (size_t)(line_end - r->pos));
+            return true;
+        }
+        // refill only while the line still fits in the current buffer
+        const char *keep = r->pos;
+        if ((size_t)(r->end - r->pos) == r->capacity || !reader_refill(r, &keep)) {
+            if (r->eof) continue;
+            return false;
+        }
+    }
+}
+
+// Get production index for a non-terminal and terminal ID: a single array index, or for a
+// compressed table the merged row, its comb entry and possibly its default
+int get_production(const ParsingTable *table, int nt, int term) {
+    int row = nt - table->num_terminals;
+    if (row < 0 || term < 0 || term >= table->num_terminals) {
+        return NO_PRODUCTION; // not a non-terminal / unknown terminal
+    }
+    if (table->comb) {
+        int merged = table->row_of[row];
+        const ZLL1CombEntry *entry = table->comb + table->row_base[merged] + term;
+        return entry->row == merged ? entry->production : table->row_defaults[merged];
+    }
+    return table->actions[(size_t)row * table->num_terminals + term];
+}
+
+// RHS text of a production, for display
+const char* production_text(const ParsingTable *table, int production) {
+    return table->strings + table->productions[production].text_offset;
+}
+
+TraceLevel trace_level = TRACE_LEVEL_SUMMARY;
+const char *trace_path = "parse_trace.bin";
+
+// Trace file shared by all workers; created on the first dump
+FILE *trace_file = NULL;
+std::mutex trace_file_lock;
+
+void worker_init(ParseWorker *w) {
+    memset(w, 0, sizeof(*w));
+    if (trace_level == TRACE_LEVEL_STEPS) {
+        w->ring.capacity = TRACE_RING_SIZE;
+        w->ring.records = (TraceRecord *)malloc(TRACE_RING_SIZE * sizeof(TraceRecord));
+        if (!w->ring.records) {
+            fprintf(stderr, "Out of memory!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void worker_free(ParseWorker *w) {
+    arena_free(&w->arena);
+    free(w->ring.records);
+    w->ring.records = NULL;
+}
+
+// printf into the worker's output
+static void emit(ParseWorker *w, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (w->output == NULL) {
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+    OutputBuffer *out = w->output;
+    for (;;) {
+        va_list copy;
+        va_copy(copy, args);
+        size_t room = out->capacity - out->size;
+        int n = vsnprintf(out->data ? out->data + out->size : NULL, room, format, copy);
+        va_end(copy);
+        if (n < 0) break;
+        if ((size_t)n < room) {
+            out->size += (size_t)n;
+            break;
+        }
+        size_t capacity = out->capacity ? out->capacity * 2 : 4096;
+        while (capacity - out->size <= (size_t)n) capacity *= 2;
+        char *data = (char *)realloc(out->data, capacity);
+        if (!data) {
+            fprintf(stderr, "Out of memory!\n");
+            exit(EXIT_FAILURE);
+        }
+        out->data = data;
+        out->capacity = capacity;
+    }
+    va_end(args);
+}
+
+// Append one step record to the worker's ring
+static inline void trace_record(ParseWorker *w, TraceKind kind, uint32_t step, const Stack *s, int lookahead, int32_t arg) {
+    TraceRecord record;
+    record.step = step;
+    record.top = s->top >= 0 ? s->items[s->top] : -1;
+    record.lookahead = lookahead;
+    record.arg = arg;
+    record.kind = (uint16_t)kind;
+    record.reserved = 0;
+    record.depth = (uint32_t)(s->top + 1);
+    trace_ring_push(&w->ring, record);
+}
+
+// Write the worker's records from ring position `from` to the trace file as one segment.
+// The file starts with a copy of the table.
+void trace_dump(const ParsingTable *table, ParseWorker *w, uint64_t from) {
+    TraceRing *ring = &w->ring;
+    if (from < w->trace_dumped) from = w->trace_dumped;
+    if (ring->head == from) return;
+
+    std::lock_guard<std::mutex> guard(trace_file_lock);
+    if (trace_file == NULL) {
+        trace_file = fopen(trace_path, "wb");
+        if (!trace_file) {
+            perror("Error creating trace file");
+            exit(EXIT_FAILURE);
+        }
+        TraceFileHeader header = {ZTRC_MAGIC, ZTRC_VERSION, table->header->file_size};
+        fwrite(&header, sizeof(header), 1, trace_file);
+        fwrite(table->header, 1, table->header->file_size, trace_file);
+    }
+
+    TraceSegmentHeader segment;
+    segment.dropped = 0;
+    if (ring->head - from > ring->capacity) {
+        segment.dropped = ring->head - from - ring->capacity;
+        from = ring->head - ring->capacity;
+    }
+    segment.record_count = ring->head - from;
+    fwrite(&segment, sizeof(segment), 1, trace_file);
+
+    // the range wraps around the end of the ring at most once
+    uint64_t mask = ring->capacity - 1;
+    uint64_t first = from & mask;
+    uint64_t count = segment.record_count;
+    uint64_t until_end = ring->capacity - first < count ? ring->capacity - first : count;
+    fwrite(ring->records + first, sizeof(TraceRecord), until_end, trace_file);
+    fwrite(ring->records, sizeof(TraceRecord), count - until_end, trace_file);
+    w->trace_dumped = ring->head;
+}
+
+// Parse the current line of the reader, pulling tokens one at a time.
+// Returns true if the line was accepted.
+bool parse_input(const ParsingTable *table, ParseWorker *w, TokenReader *reader) {
+    size_t allocations_before = allocation_count;
+    arena_reset(&w->arena);
+    Stack s;
+    stack_init(&s, &w->arena, table, table->header->start_symbol);
+
+    bool verbose = trace_level == TRACE_LEVEL_VERBOSE;
+    bool record = trace_level == TRACE_LEVEL_STEPS;
+    size_t line_number = reader->line_number;
+    uint64_t trace_start = w->ring.head;
+
+    // Echo the line when it is in memory as a whole (streamed lines may not be)
+    if (verbose) {
+        std::string_view line;
+        if (reader_line_view(reader, &line)) {
+            emit(w, "\nParsing: %.*s\n", (int)line.size(), line.data());
+        } else {
+            emit(w, "\nParsing: line %zu\n", line_number);
+        }
+        emit(w, "-------------------------------\n");
+    }
+
+    std::string_view token;
+    bool has_token = reader_next_token(reader, &token); // Initial token
+    int token_id = has_token ? lookup_symbol(table, token) : table->end_marker; // resolved once per token
+    uint32_t step = 0;
+    size_t tokens = 0;
+    ParseStatus status = PARSE_ACCEPTED;
+    int error_symbol = -1;
+
+    if (record) trace_record(w, TRACE_BEGIN, 0, &s, token_id, (int32_t)line_number);
+
+    while (stack_peek(&s) != -1) {
+        step++;
+        // Determine current input symbol (use $ at the end of the line)
+        std::string_view current_input = has_token ? token : std::string_view("$");
+        if (verbose) {
+            // Print current stack and input
+            emit(w, "Step %u:\n", step);
+            emit(w, "Stack: ");
+            for (int i = s.top; i >= 0; i--) {
+                emit(w, "%s ", symbol_name(table, s.items[i]));
+            }
+            emit(w, "\nInput: %.*s\n", (int)current_input.size(), current_input.data());
+        }
+
+        int top = stack_peek(&s);
+
+        // Check for terminal match or end of input
+        if (top == token_id) {
+            if (top == table->end_marker) { // Both stack top and input are $
+                if (record) trace_record(w, TRACE_ACCEPT, step, &s, token_id, 0);
+                if (verbose) emit(w, "Action: Accept\n");
+                break; // Successful parse
+            } else { // Matched a terminal
+                if (record) trace_record(w, TRACE_MATCH, step, &s, token_id, 0);
+                if (verbose) emit(w, "Action: Match '%.*s'\n", (int)token.size(), token.data());
+                stack_pop(&s);
+                tokens++;
+                has_token = reader_next_token(reader, &token); // Get next token
+                token_id = has_token ? lookup_symbol(table, token) : table->end_marker;
+            }
+        } else { // Top is a non-terminal, need to expand
+            int prod = get_production(table, top, token_id);
+            if (prod == NO_PRODUCTION) {
+                status = PARSE_NO_PRODUCTION;
+                error_symbol = top;
+                if (record) trace_record(w, TRACE_ERROR, step, &s, token_id, status);
+                if (verbose) emit(w, "Error: No production for %s on input '%.*s'\n", symbol_name(table, top), (int)current_input.size(), current_input.data());
+                break;
+            }
+            if (record) trace_record(w, TRACE_EXPAND, step, &s, token_id, prod);
+            if (verbose) emit(w, "Action: Expand %s -> %s\n", symbol_name(table, top), production_text(table, prod));
+            stack_pop(&s);
+
+            // Push the RHS (nothing for epsilon)
+            const ZLL1Production *p = &table->productions[prod];
+            stack_push_rhs(&s, table->rhs + p->rhs_offset, p->rhs_length);
+        }
+        if (verbose) emit(w, "\n"); // Add newline for better formatting
+    }
+
+    // Final check after loop
+    bool stack_at_end = stack_peek(&s) == table->end_marker;
+    if (status == PARSE_ACCEPTED && has_token && stack_at_end) {
+        // If stack is accepted ($) but there's still input left
+        status = PARSE_INPUT_REMAINING;
+        if (verbose) emit(w, "Error: Stack accepted but input remaining: %.*s\n", (int)token.size(), token.data());
+    } else if (status == PARSE_ACCEPTED && !stack_at_end) {
+        // If input is exhausted (token is NULL) but stack isn't $
+        status = PARSE_STACK_REMAINING;
+        error_symbol = stack_peek(&s);
+        if (verbose) emit(w, "Error: Input exhausted but stack not empty. Top: %s\n", error_symbol >= 0 ? symbol_name(table, error_symbol) : "(empty)");
+    }
+    if (record) {
+        if (status == PARSE_INPUT_REMAINING || status == PARSE_STACK_REMAINING) {
+            trace_record(w, TRACE_ERROR, step, &s, token_id, status);
+        }
+        trace_record(w, TRACE_END, step, &s, token_id, status);
+        if (status != PARSE_ACCEPTED) trace_dump(table, w, trace_start);
+    }
+
+    size_t allocations = allocation_count - allocations_before;
+    if (verbose) {
+        emit(w, status == PARSE_ACCEPTED ? "\nParsing succeeded.\n" : "\nParsing failed with errors.\n");
+        emit(w, "Heap allocations: %zu\n", allocations);
+        emit(w, "-------------------------------\n");
+    } else if (trace_level != TRACE_LEVEL_SILENT) {
+        std::string_view current_input = has_token ? token : std::string_view("$");
+        switch (status) {
+            case PARSE_ACCEPTED:
+                emit(w, "line %zu: accepted (%zu tokens, %u steps, %zu heap allocations)\n", line_number, tokens, step, allocations);
+                break;
+            case PARSE_NO_PRODUCTION:
+                emit(w, "line %zu: rejected at step %u: no production for %s on input '%.*s'\n", line_number, step,
+                     symbol_name(table, error_symbol), (int)current_input.size(), current_input.data());
+                break;
+            case PARSE_INPUT_REMAINING:
+                emit(w, "line %zu: rejected at step %u: input remaining: %.*s\n", line_number, step, (int)token.size(), token.data());
+                break;
+            case PARSE_STACK_REMAINING:
+                emit(w, "line %zu: rejected at step %u: input exhausted, stack top %s\n", line_number, step,
+                     error_symbol >= 0 ? symbol_name(table, error_symbol) : "(empty)");
+                break;
+        }
+    }
+
+    w->totals.lines++;
+    w->totals.tokens += tokens;
+    w->totals.steps += step;
+    if (status == PARSE_ACCEPTED) w->totals.accepted++;
+    return status == PARSE_ACCEPTED;
+}
+
+// One work item of batch mode: whole lines of the mapped input
+typedef struct {
+    const char *begin;
+    const char *end;
+    size_t first_line;                      // lines before the chunk
+    OutputBuffer output;
+    std::atomic<bool> done;
+} InputChunk;
+
+// A worker's share of the chunks, as a packed [begin, end) range of k where the chunk
+// index is owner + k * workers. The owner takes from the front and thieves from the
+// back, each with a single CAS.
+typedef struct {
+    std::atomic<uint64_t> range;
+} ChunkQueue;
+
+static bool queue_take(ChunkQueue *q, bool from_back, uint32_t *k) {
+    uint64_t range = q->range.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t begin = (uint32_t)(range >> 32);
+        uint32_t end = (uint32_t)range;
+        if (begin >= end) return false;
+        uint64_t next = from_back ? ((uint64_t)begin << 32 | (end - 1)) : ((uint64_t)(begin + 1) << 32 | end);
+        if (q->range.compare_exchange_weak(range, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            *k = from_back ? end - 1 : begin;
+            return true;
+        }
+    }
+}
+
+// Parse the mapped input with `jobs` threads. Chunks are dealt out round-robin so all
+// workers move through the file together, idle workers steal from the others, and the
+// calling thread writes each chunk's output in input order as soon as it is complete.
+void parse_batch(const ParsingTable *table, TokenReader *input, int jobs, ParseTotals *totals) {
+    // Split into chunks of whole lines, counting lines for the numbering
+    auto chunk_end = [input](const char *begin) {
+        size_t left = (size_t)(input->end - begin);
+        if (left <= BATCH_CHUNK_SIZE) return input->end;
+        const char *newline = (const char *)memchr(begin + BATCH_CHUNK_SIZE, '\n', left - BATCH_CHUNK_SIZE);
+        return newline ? newline + 1 : input->end;
+    };
+    size_t count = 0;
+    for (const char *p = input->pos; p < input->end; p = chunk_end(p)) count++;
+
+    std::vector<InputChunk> chunks(count);
+    size_t lines = 0;
+    const char *p = input->pos;
+    for (InputChunk &chunk : chunks) {
+        chunk.begin = p;
+        chunk.end = chunk_end(p);
+        chunk.first_line = lines;
+        chunk.output = {NULL, 0, 0};
+        chunk.done.store(false, std::memory_order_relaxed);
+        lines += (size_t)std::count(chunk.begin, chunk.end, '\n');
+        p = chunk.end;
+    }
+    if (chunks.empty()) return;
+    if ((size_t)jobs > chunks.size()) jobs = (int)chunks.size();
+
+    std::vector<ChunkQueue> queues(jobs);
+    for (int w = 0; w < jobs; w++) {
+        uint64_t owned = (chunks.size() - (size_t)w + jobs - 1) / jobs;
+        queues[w].range.store(owned, std::memory_order_relaxed);
+    }
+    std::vector<ParseWorker> workers(jobs);
+    std::mutex done_lock;
+    std::condition_variable done_signal;
+
+    auto run = [&](int w) {
+        ParseWorker *worker = &workers[w];
+        for (;;) {
+            uint32_t k;
+            int owner = w;
+            if (!queue_take(&queues[w], false, &k)) {
+                // steal the furthest chunk of the next worker that has any left
+                int victim = -1;
+                for (int i = 1; i < jobs && victim < 0; i++) {
+                    int other = (w + i) % jobs;
+                    if (queue_take(&queues[other], true, &k)) victim = other;
+                }
+                if (victim < 0) return;
+                owner = victim;
+            }
+            InputChunk &chunk = chunks[(size_t)owner + (size_t)k * jobs];
+
+            TokenReader reader;
+            reader_open_range(&reader, chunk.begin, chunk.end, chunk.first_line);
+            worker->output = &chunk.output;
+            while (reader_next_line(&reader)) {
+                parse_input(table, worker, &reader);
+            }
+            worker->output = NULL;
+
+            {
+                std::lock_guard<std::mutex> guard(done_lock);
+                chunk.done.store(true, std::memory_order_release);
+            }
+            done_signal.notify_one();
+        }
+    };
+
+    for (int w = 0; w < jobs; w++) worker_init(&workers[w]);
+    std::vector<std::thread> threads;
+    for (int w = 0; w < jobs; w++) threads.emplace_back(run, w);
+
+    // Ordered output; input pages behind the written chunks are dropped as in TokenReader
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const char *released = input->mapping;
+    for (InputChunk &chunk : chunks) {
+        {
+            std::unique_lock<std::mutex> guard(done_lock);
+            done_signal.wait(guard, [&chunk] { return chunk.done.load(std::memory_order_acquire); });
+        }
+        fwrite(chunk.output.data, 1, chunk.output.size, stdout);
+        free(chunk.output.data);
+        chunk.output = {NULL, 0, 0};
+
+        const char *upto = input->mapping + ((size_t)(chunk.end - input->mapping) & ~(page - 1));
+        if ((size_t)(upto - released) >= INPUT_RELEASE_SIZE) {
+            madvise((void *)released, (size_t)(upto - released), MADV_DONTNEED);
+            released = upto;
+        }
+    }
+
+    for (std::thread &thread : threads) thread.join();
+    for (ParseWorker &worker : workers) {
+        totals->lines += worker.totals.lines;
+        totals->accepted += worker.totals.accepted;
+        totals->tokens += worker.totals.tokens;
+        totals->steps += worker.totals.steps;
+        if (trace_level == TRACE_LEVEL_STEPS) trace_dump(table, &worker, worker.trace_dumped);
+        worker_free(&worker);
+    }
+}
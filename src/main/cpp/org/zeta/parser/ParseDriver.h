@@ -0,0 +1,166 @@
+//
+// LL(1) parse driver used by Stack.cpp, Benchmark.cpp, Parser.cpp and ZetaParser.cpp: the
+// loaded parsing table, per-parse storage, streaming token input and the parse loop itself.
+//
+#ifndef ZETA_PARSE_DRIVER_H
+#define ZETA_PARSE_DRIVER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <vector>
+#include <string_view>
+#include "ParseTableFormat.h"
+#include "ParseTrace.h"
+
+#define STACK_INLINE_SIZE 256        // stack slots available before the arena is used
+#define NO_PRODUCTION ZLL1_NO_PRODUCTION
+
+// LL(1) parsing table in the compiled layout of ParseTableFormat.h. It is either mmap'ed
+// from the binary table and used in place, or built in memory from the CSV export.
+// Once loaded it is never modified, so any number of threads can share a const pointer.
+// Every symbol has a dense ID: terminals take [0, num_terminals) and double as column
+// indices, non-terminals take the following IDs and map to rows.
+typedef struct {
+    const ZLL1Header *header;
+    const ZLL1Symbol *symbols;
+    const char *strings;
+    const int32_t *actions;                 // [row * num_terminals + column] -> production index
+    const ZLL1CombEntry *comb;              // compressed actions instead, if not NULL (see ParseTableFormat.h)
+    const int32_t *row_of;
+    const int32_t *row_base;
+    const int32_t *row_defaults;
+    const ZLL1Production *productions;
+    const int32_t *rhs;
+    int num_terminals;
+    int num_nonterminals;
+    int end_marker;                         // ID of "$"
+    void *mapping;                          // mmap'ed binary table, if any
+    size_t mapping_size;
+    std::vector<char> image;                // table built from the CSV, if any
+} ParsingTable;
+
+// Arena block header; the block's memory follows it
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+} ArenaBlock;
+
+// Bump allocator for per-parse storage. Memory is never freed piecemeal: arena_reset
+// rewinds to the first block and keeps every block, so once a parse has grown the
+// arena, later parses of similar size reuse it without touching the heap.
+typedef struct {
+    ArenaBlock *first;
+    ArenaBlock *current;
+    size_t used;                            // bytes used in current
+} Arena;
+
+// Stack structure: symbol IDs. Starts in the inline array and moves to
+// arena storage of doubling capacity when it outgrows it.
+typedef struct {
+    int32_t *items;
+    int top;
+    int capacity;
+    Arena *arena;
+    int32_t inline_items[STACK_INLINE_SIZE];
+} Stack;
+
+// Streaming token input. A file is mmap'ed and scanned in place; stdin (or any fd) is
+// read in fixed-size chunks. Tokens are string_views into the mapping or the chunk
+// buffer and stay valid until the next reader call, so nothing is copied and memory
+// does not grow with the size of the input.
+typedef struct {
+    const char *pos;                        // next unread byte
+    const char *end;                        // end of the mapped / buffered data
+    bool in_line;                           // pos is inside a line handed to the driver
+    size_t line_number;                     // 1-based number of the current line
+    // mmap mode
+    const char *mapping;
+    size_t mapping_size;
+    const char *released;                   // pages before this were dropped with madvise
+    // stream mode
+    int fd;
+    char *buffer;
+    size_t capacity;
+    bool eof;
+} TokenReader;
+
+// How much the driver reports
+typedef enum {
+    TRACE_LEVEL_SILENT,                     // nothing per line
+    TRACE_LEVEL_SUMMARY,                    // one line per parse
+    TRACE_LEVEL_STEPS,                      // summary + binary step records (ParseTrace.h)
+    TRACE_LEVEL_VERBOSE,                    // stack, input and action printed at every step
+} TraceLevel;
+
+// Totals over all parsed lines
+typedef struct {
+    size_t lines;
+    size_t accepted;
+    size_t tokens;
+    size_t steps;
+} ParseTotals;
+
+// Growable output buffer (malloc'ed so it does not show up in the allocation counts)
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} OutputBuffer;
+
+// Everything a parse may modify. Each thread owns one; the table is shared read-only.
+typedef struct {
+    Arena arena;
+    TraceRing ring;
+    uint64_t trace_dumped;                  // ring position up to which records were written
+    ParseTotals totals;
+    OutputBuffer *output;                   // NULL: print straight to stdout
+} ParseWorker;
+
+// Options, set once before any parsing starts
+extern TraceLevel trace_level;
+extern const char *trace_path;
+extern FILE *trace_file;                    // created by the first trace dump, closed by the caller
+
+// Heap allocations made through operator new by the current thread, reported per parse to
+// confirm that the driver loop itself does not allocate. Only tools linking AllocationCount.cpp
+// (Stack, Benchmark) count them; everywhere else, the libraries included, it stays 0.
+extern thread_local size_t allocation_count;
+
+// Parsing table
+void load_parsing_table(ParsingTable *table, const char *filename);
+bool load_parsing_table_binary(ParsingTable *table, const char *filename);
+void load_parsing_table_image(ParsingTable *table, const void *data, size_t size);
+void unload_parsing_table(ParsingTable *table);
+int lookup_symbol(const ParsingTable *table, std::string_view symbol);
+const char* symbol_name(const ParsingTable *table, int id);
+int get_production(const ParsingTable *table, int nt, int term);
+const char* production_text(const ParsingTable *table, int production);
+
+// Arena and stack
+void* arena_alloc(Arena *a, size_t bytes);
+void arena_reset(Arena *a);
+void arena_free(Arena *a);
+void stack_init(Stack *s, Arena *arena, const ParsingTable *table, int start_symbol);
+void stack_reserve(Stack *s, size_t needed);
+void stack_push_rhs(Stack *s, const int32_t *reversed_rhs, uint32_t length);
+int stack_pop(Stack *s);
+int stack_peek(Stack *s);
+
+// Token input
+bool reader_open_file(TokenReader *r, const char *filename);
+void reader_open_stream(TokenReader *r, int fd);
+void reader_open_range(TokenReader *r, const char *begin, const char *end, size_t first_line);
+void reader_close(TokenReader *r);
+bool reader_next_line(TokenReader *r);
+bool reader_next_token(TokenReader *r, std::string_view *token);
+bool reader_line_view(TokenReader *r, std::string_view *line);
+
+// Parsing
+void worker_init(ParseWorker *w);
+void worker_free(ParseWorker *w);
+void trace_dump(const ParsingTable *table, ParseWorker *w, uint64_t from);
+bool parse_input(const ParsingTable *table, ParseWorker *w, TokenReader *reader);
+void parse_batch(const ParsingTable *table, TokenReader *input, int jobs, ParseTotals *totals);
+
+#endif // ZETA_PARSE_DRIVER_H
@@ -0,0 +1,680 @@
+//
+// Compiled LL(1) parsing table shared by Parser.cpp (writer) and Stack.cpp (reader).
+//
+// The file is designed to be mmap'ed and used in place: every section is a flat
+// array at a fixed offset, symbol names are NUL-terminated in one string pool and
+// a prebuilt hash index resolves input tokens without building any map at load time.
+//
+// Layout (native little-endian, every section 8-byte aligned):
+//   ZLL1Header
+//   ZLL1Symbol     symbols[num_symbols]         terminals first, then non-terminals
+//   char           strings[strings_size]        symbol names and production texts
+//   int32_t        hash[hash_buckets]           symbol IDs by name hash, -1 = empty bucket
+//   int32_t        actions[rows * num_terminals] production per (non-terminal, terminal),
+//                                               or a compressed table (ZLL1_FLAG_COMPRESSED_ACTIONS)
+//   ZLL1Production productions[num_productions + num_chains]
+//                                               grammar productions, then expansion chains
+//                                               (ZLL1_FLAG_EXPANSION_CHAINS)
+//   int32_t        rhs[rhs_count]               RHS symbol IDs of all productions, each
+//                                               stored reversed so it can be pushed in one copy
+//
+// Version history:
+//   1  initial layout
+//   2  RHS arrays stored reversed
+//   3  header flags, optional row-displacement compressed actions (version 2 files still load)
+//   4  header num_chains, optional expansion chains (version 2 and 3 files still load)
+//
+#ifndef ZETA_PARSE_TABLE_FORMAT_H
+#define ZETA_PARSE_TABLE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define ZLL1_MAGIC 0x314C4C5Au /* "ZLL1" */
+#define ZLL1_VERSION 4
+#define ZLL1_NO_PRODUCTION -1
+
+// Header flags
+#define ZLL1_FLAG_COMPRESSED_ACTIONS 1u     // the actions section is a ZLL1CompressedActions table
+#define ZLL1_FLAG_DEFAULT_PRODUCTIONS 2u    // empty cells answer with the row's default production
+#define ZLL1_FLAG_EXPANSION_CHAINS 4u       // cells may name an expansion chain instead of a production
+
+#define ZLL1_MAX_CHAIN_EXPANSIONS 64        // longer chains (only possible with conflicts) are cut
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_symbols;
+    uint32_t num_terminals;      // symbol IDs [0, num_terminals) are terminals and table columns
+    uint32_t num_productions;
+    int32_t start_symbol;        // symbol ID of the start non-terminal
+    uint32_t hash_buckets;       // power of two
+    uint32_t flags;              // ZLL1_FLAG_*
+    uint64_t file_size;
+    uint64_t symbols_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t hash_offset;
+    uint64_t actions_offset;
+    uint64_t productions_offset;
+    uint64_t rhs_offset;
+    uint64_t rhs_count;
+    uint32_t num_chains;         // records after the grammar productions (version 4)
+    uint32_t reserved;
+} ZLL1Header;
+
+typedef struct {
+    uint32_t name_offset;        // into the string pool
+    uint32_t name_length;
+} ZLL1Symbol;
+
+typedef struct {
+    int32_t lhs;                 // non-terminal symbol ID
+    uint32_t rhs_offset;         // index in rhs[] of the reversed RHS (last symbol first)
+    uint32_t rhs_length;         // 0 for an ε-production
+    uint32_t text_offset;        // RHS as written in the grammar ("ε" for empty), for display
+} ZLL1Production;
+
+// Compressed actions by row displacement. Identical rows are merged; the cells of every merged
+// row are then laid into one shared comb vector at a per-row displacement (base), where each
+// entry remembers the merged row that owns it. A cell whose entry belongs to another row is
+// empty, or with ZLL1_FLAG_DEFAULT_PRODUCTIONS takes the row's most common production (cells
+// holding that production are left out of the comb). Deferring errors that way is safe for
+// LL(1): the default expansion fails on the same token a little later.
+// The section is this header followed by
+//   int32_t       row_of[rows]            merged row of every non-terminal row
+//   int32_t       base[num_rows]          displacement of each merged row in comb
+//   int32_t       defaults[num_rows]      production for cells not in comb
+//   ZLL1CombEntry comb[comb_size]         padded so that base + column is always in range
+typedef struct {
+    uint32_t num_rows;
+    uint32_t comb_size;
+} ZLL1CompressedActions;
+
+typedef struct {
+    int32_t production;
+    int32_t row;                 // owning merged row, -1 for a free slot
+} ZLL1CombEntry;
+
+// Expansion chains. For a non-terminal A on top of the stack and lookahead a, the leftmost
+// expansions the driver performs until a terminal is on top (or A and whatever it expanded to
+// are gone) depend on nothing but the table, so they can be done ahead of time: a chain is an
+// extra production record A -> (net symbols left on the stack) and the cell names the chain,
+// letting the driver do the whole sequence as one expansion. Chains come after the grammar
+// productions; a cell whose production already starts with a terminal keeps the production.
+
+// Sizes of the expansion chains of a table, for reports
+typedef struct {
+    size_t cells;                // cells that name a chain
+    size_t chains;               // distinct chains
+    size_t expansions;           // expansions the chains stand for
+    size_t rhs_symbols;          // RHS symbols they add
+} ZLL1ChainStats;
+
+// Sizes of a compressed action table, for reports
+typedef struct {
+    size_t rows;
+    size_t merged_rows;
+    size_t cells;                // non-empty cells of the dense table
+    size_t comb_entries;         // cells stored in the comb (cells minus defaulted ones)
+    size_t comb_size;
+    size_t dense_bytes;
+    size_t compressed_bytes;
+} ZLL1CompressionStats;
+
+// Production handed to zll1_build, RHS in grammar order
+typedef struct {
+    int32_t lhs;
+    std::vector<int32_t> rhs;
+    std::string text;
+} ZLL1SourceProduction;
+
+// One row of an action table as handed to the writer: its non-empty cells as (column,
+// production), in column order. Large grammars leave most cells empty, so rows are only
+// spread out into the dense section when an uncompressed table is written.
+typedef std::vector<std::pair<uint32_t, int32_t>> ZLL1ActionRow;
+
+// FNV-1a, used for the symbol hash index (constexpr for ConstexprGrammar.h)
+constexpr uint32_t zll1_hash(const char *name, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+inline size_t zll1_align(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+// Expansion chain records after the grammar productions. The header of versions 2 and 3 ends
+// before num_chains (the symbols section follows it), so they have none.
+inline uint32_t zll1_num_chains(const ZLL1Header *h) {
+    return h->version >= 4 && (h->flags & ZLL1_FLAG_EXPANSION_CHAINS) ? h->num_chains : 0;
+}
+
+// Section accessors for an image that passed zll1_validate
+inline const ZLL1Symbol *zll1_symbols(const ZLL1Header *h) {
+    return (const ZLL1Symbol *)((const char *)h + h->symbols_offset);
+}
+inline const char *zll1_strings(const ZLL1Header *h) {
+    return (const char *)h + h->strings_offset;
+}
+inline const int32_t *zll1_hash_index(const ZLL1Header *h) {
+    return (const int32_t *)((const char *)h + h->hash_offset);
+}
+inline const int32_t *zll1_actions(const ZLL1Header *h) {
+    return (const int32_t *)((const char *)h + h->actions_offset);
+}
+inline const ZLL1CompressedActions *zll1_compressed_actions(const ZLL1Header *h) {
+    return (const ZLL1CompressedActions *)((const char *)h + h->actions_offset);
+}
+inline const int32_t *zll1_row_of(const ZLL1Header *h) {
+    return (const int32_t *)(zll1_compressed_actions(h) + 1);
+}
+inline const int32_t *zll1_row_base(const ZLL1Header *h) {
+    return zll1_row_of(h) + (h->num_symbols - h->num_terminals);
+}
+inline const int32_t *zll1_row_defaults(const ZLL1Header *h) {
+    return zll1_row_base(h) + zll1_compressed_actions(h)->num_rows;
+}
+inline const ZLL1CombEntry *zll1_comb(const ZLL1Header *h) {
+    return (const ZLL1CombEntry *)(zll1_row_defaults(h) + zll1_compressed_actions(h)->num_rows);
+}
+inline const ZLL1Production *zll1_productions(const ZLL1Header *h) {
+    return (const ZLL1Production *)((const char *)h + h->productions_offset);
+}
+inline const int32_t *zll1_rhs(const ZLL1Header *h) {
+    return (const int32_t *)((const char *)h + h->rhs_offset);
+}
+
+// Find a symbol ID by name through the hash index, -1 if unknown
+inline int zll1_find_symbol(const ZLL1Header *h, const char *name, size_t length) {
+    const ZLL1Symbol *symbols = zll1_symbols(h);
+    const char *strings = zll1_strings(h);
+    const int32_t *index = zll1_hash_index(h);
+    uint32_t mask = h->hash_buckets - 1;
+
+    for (uint32_t b = zll1_hash(name, length) & mask;; b = (b + 1) & mask) {
+        int32_t id = index[b];
+        if (id < 0) return -1;
+        if (symbols[id].name_length == length && memcmp(strings + symbols[id].name_offset, name, length) == 0) {
+            return id;
+        }
+    }
+}
+
+// Production for a (non-terminal row, terminal) cell, dense or compressed.
+// Tools use this; the parse driver keeps the section pointers and inlines the same lookup.
+inline int32_t zll1_lookup(const ZLL1Header *h, int row, int column) {
+    if (!(h->flags & ZLL1_FLAG_COMPRESSED_ACTIONS)) {
+        return zll1_actions(h)[(size_t)row * h->num_terminals + column];
+    }
+    int32_t merged = zll1_row_of(h)[row];
+    const ZLL1CombEntry *entry = zll1_comb(h) + zll1_row_base(h)[merged] + column;
+    return entry->row == merged ? entry->production : zll1_row_defaults(h)[merged];
+}
+
+// Check that the header and every section fit inside size bytes. Section contents are
+// trusted (the file is produced by Parser), so this is O(1) and touches only the header
+// (and the compressed actions header, if any). Images from elsewhere also need
+// zll1_check_contents.
+inline bool zll1_validate(const void *data, size_t size, const char **error) {
+    const ZLL1Header *h = (const ZLL1Header *)data;
+    if (size < offsetof(ZLL1Header, num_chains) || h->magic != ZLL1_MAGIC) {
+        *error = "not a compiled parsing table";
+        return false;
+    }
+    if (h->version < 2 || h->version > ZLL1_VERSION) {
+        *error = "unsupported table format version";
+        return false;
+    }
+    if (h->version >= 4 && size < sizeof(ZLL1Header)) {
+        *error = "not a compiled parsing table";
+        return false;
+    }
+    // count elements of element bytes at offset lie inside the image (no overflow on any input)
+    auto fits = [size](uint64_t offset, uint64_t count, uint64_t element) {
+        return offset <= size && count <= (size - offset) / element;
+    };
+    uint64_t misaligned = h->symbols_offset | h->strings_offset | h->hash_offset | h->actions_offset
+                          | h->productions_offset | h->rhs_offset;
+    if (h->num_terminals > h->num_symbols || (misaligned & 7) != 0) {
+        *error = "truncated or inconsistent parsing table";
+        return false;
+    }
+    uint64_t rows = h->num_symbols - h->num_terminals;
+    uint64_t records = h->num_productions + (uint64_t)zll1_num_chains(h);
+    bool actions_fit = fits(h->actions_offset, rows * h->num_terminals, sizeof(int32_t));
+    if (h->flags & ZLL1_FLAG_COMPRESSED_ACTIONS) {
+        // header, row_of[rows], base[num_rows], defaults[num_rows], then the comb
+        actions_fit = fits(h->actions_offset, 1, sizeof(ZLL1CompressedActions));
+        if (actions_fit) {
+            const ZLL1CompressedActions *c = zll1_compressed_actions(h);
+            uint64_t arrays_offset = h->actions_offset + sizeof(ZLL1CompressedActions);
+            uint64_t arrays = rows + 2 * (uint64_t)c->num_rows;
+            actions_fit = fits(arrays_offset, arrays, sizeof(int32_t))
+                && fits(arrays_offset + arrays * sizeof(int32_t), c->comb_size, sizeof(ZLL1CombEntry));
+        }
+    }
+    bool ok = h->file_size == size
+        && h->start_symbol >= (int32_t)h->num_terminals && h->start_symbol < (int32_t)h->num_symbols
+        && h->hash_buckets != 0 && (h->hash_buckets & (h->hash_buckets - 1)) == 0
+        && h->hash_buckets > h->num_symbols
+        && fits(h->symbols_offset, h->num_symbols, sizeof(ZLL1Symbol))
+        && fits(h->strings_offset, h->strings_size, 1)
+        && fits(h->hash_offset, h->hash_buckets, sizeof(int32_t))
+        && actions_fit
+        && fits(h->productions_offset, records, sizeof(ZLL1Production))
+        && fits(h->rhs_offset, h->rhs_count, sizeof(int32_t));
+    if (!ok) {
+        *error = "truncated or inconsistent parsing table";
+        return false;
+    }
+    return true;
+}
+
+// Check that no cell can start expansions that never consume a token: with lookahead a, the
+// expansion of A -> X1 X2 ... puts X1 on top, then X2 once X1 has vanished (expanded to
+// nothing on a), and so on. A cycle through those (non-terminal, a) cells would grow the
+// stack without end, so the table is rejected. One depth-first search finds both whether a
+// cell vanishes and any cycle, following each cell's edges once.
+// Needs in-range contents (zll1_check_contents).
+inline bool zll1_check_expansions(const ZLL1Header *h, const char **error) {
+    enum : char { UNSEEN, ON_PATH, CONSUMES, VANISHES };
+    const int32_t columns = (int32_t)h->num_terminals;
+    const size_t cells = (size_t)(h->num_symbols - h->num_terminals) * columns;
+    const ZLL1Production *productions = zll1_productions(h);
+    const int32_t *rhs = zll1_rhs(h);
+    std::vector<char> state(cells, UNSEEN);
+    std::vector<std::pair<size_t, uint32_t>> path;     // cell, RHS position (grammar order) to visit next
+
+    for (size_t root = 0; root < cells; root++) {
+        if (state[root] != UNSEEN) continue;
+        state[root] = ON_PATH;
+        path.push_back({root, 0});
+        while (!path.empty()) {
+            size_t cell = path.back().first;
+            uint32_t &next = path.back().second;
+            int32_t p = zll1_lookup(h, (int)(cell / columns), (int)(cell % columns));
+            // an empty cell stops the parse, a terminal waits for a token: neither vanishes
+            char result = p == ZLL1_NO_PRODUCTION ? CONSUMES : 0;
+            size_t target = 0;
+            while (!result) {
+                if (next == productions[p].rhs_length) {
+                    result = VANISHES;
+                    break;
+                }
+                // the RHS is stored reversed
+                int32_t x = rhs[productions[p].rhs_offset + productions[p].rhs_length - 1 - next];
+                if (x < columns) {
+                    result = CONSUMES;
+                    break;
+                }
+                target = (size_t)(x - columns) * columns + cell % columns;
+                if (state[target] == ON_PATH) {
+                    *error = "expansion cycle in parsing table";
+                    return false;
+                }
+                if (state[target] == UNSEEN) break;
+                if (state[target] == CONSUMES) result = CONSUMES;
+                else next++;
+            }
+            if (result) {
+                state[cell] = result;
+                path.pop_back();
+            } else {
+                // resumed at the same position, once the target's state is known
+                state[target] = ON_PATH;
+                path.push_back({target, 0});
+            }
+        }
+    }
+    return true;
+}
+
+// Check every value the parse driver follows in an image that passed zll1_validate: string
+// offsets, hash index IDs, production records and RHS symbols, and every action (dense, or
+// row_of, bases, defaults and comb entries when compressed). One pass over the image, for
+// tables that do not come from this build's Parser (the C API of ZetaParser.h loads any).
+inline bool zll1_check_contents(const void *data, const char **error) {
+    const ZLL1Header *h = (const ZLL1Header *)data;
+    const int64_t symbols = h->num_symbols;
+    const int64_t columns = h->num_terminals;
+    const uint64_t rows = (uint64_t)(symbols - columns);
+    const uint64_t records = h->num_productions + (uint64_t)zll1_num_chains(h);
+    const char *strings = zll1_strings(h);
+    auto bad = [error](const char *what) {
+        *error = what;
+        return false;
+    };
+    auto production_ok = [records](int32_t p) { return p == ZLL1_NO_PRODUCTION || (p >= 0 && (uint64_t)p < records); };
+
+    // every string ends at a NUL inside the pool once the pool itself ends with one
+    if (h->strings_size == 0 || strings[h->strings_size - 1] != '\0') return bad("unterminated string pool");
+    for (int64_t id = 0; id < symbols; id++) {
+        const ZLL1Symbol &symbol = zll1_symbols(h)[id];
+        if ((uint64_t)symbol.name_offset + symbol.name_length >= h->strings_size) return bad("symbol name out of range");
+    }
+    // lookups probe until an empty bucket, so there must be one
+    const int32_t *index = zll1_hash_index(h);
+    bool has_empty_bucket = false;
+    for (uint32_t b = 0; b < h->hash_buckets; b++) {
+        if (index[b] < -1 || index[b] >= symbols) return bad("symbol index out of range");
+        has_empty_bucket |= index[b] == -1;
+    }
+    if (!has_empty_bucket) return bad("symbol index has no empty bucket");
+    int32_t end_marker = zll1_find_symbol(h, "$", 1);
+    if (end_marker < 0 || end_marker >= columns) return bad("no end marker terminal");
+
+    const int32_t *rhs = zll1_rhs(h);
+    for (uint64_t r = 0; r < h->rhs_count; r++) {
+        if (rhs[r] < 0 || rhs[r] >= symbols) return bad("RHS symbol out of range");
+    }
+    for (uint64_t p = 0; p < records; p++) {
+        const ZLL1Production &production = zll1_productions(h)[p];
+        if (production.lhs < columns || production.lhs >= symbols
+            || (uint64_t)production.rhs_offset + production.rhs_length > h->rhs_count
+            || production.text_offset >= h->strings_size) {
+            return bad("production record out of range");
+        }
+    }
+
+    if (!(h->flags & ZLL1_FLAG_COMPRESSED_ACTIONS)) {
+        const int32_t *actions = zll1_actions(h);
+        for (uint64_t cell = 0; cell < rows * columns; cell++) {
+            if (!production_ok(actions[cell])) return bad("action out of range");
+        }
+    } else {
+        const ZLL1CompressedActions *c = zll1_compressed_actions(h);
+        for (uint64_t row = 0; row < rows; row++) {
+            int32_t merged = zll1_row_of(h)[row];
+            if (merged < 0 || (uint32_t)merged >= c->num_rows) return bad("merged row out of range");
+        }
+        for (uint32_t merged = 0; merged < c->num_rows; merged++) {
+            int32_t base = zll1_row_base(h)[merged];
+            if (base < 0 || (uint64_t)base + columns > c->comb_size) return bad("row displacement out of range");
+            if (!production_ok(zll1_row_defaults(h)[merged])) return bad("default production out of range");
+        }
+        const ZLL1CombEntry *comb = zll1_comb(h);
+        for (uint32_t e = 0; e < c->comb_size; e++) {
+            if (comb[e].row < -1 || comb[e].row >= (int32_t)c->num_rows) return bad("comb entry out of range");
+            if (comb[e].row >= 0 && !production_ok(comb[e].production)) return bad("action out of range");
+        }
+    }
+    return zll1_check_expansions(h, error);
+}
+
+// Production of a cell of an action row, ZLL1_NO_PRODUCTION if it is empty
+inline int32_t zll1_row_action(const ZLL1ActionRow &row, uint32_t column) {
+    auto cell = std::lower_bound(row.begin(), row.end(), column,
+                                 [](const std::pair<uint32_t, int32_t> &c, uint32_t col) { return c.first < col; });
+    return cell != row.end() && cell->first == column ? cell->second : ZLL1_NO_PRODUCTION;
+}
+
+// Spread action rows into the dense rows x columns table of an uncompressed actions section
+// (stats: no merged rows and no comb, compressed_bytes 0)
+inline std::vector<int32_t> zll1_dense_actions(const std::vector<ZLL1ActionRow> &rows, uint32_t columns,
+                                               ZLL1CompressionStats *stats = nullptr) {
+    std::vector<int32_t> actions(rows.size() * columns, ZLL1_NO_PRODUCTION);
+    size_t cells = 0;
+    for (size_t r = 0; r < rows.size(); r++) {
+        for (const auto &cell : rows[r]) actions[r * columns + cell.first] = cell.second;
+        cells += rows[r].size();
+    }
+    if (stats) *stats = {rows.size(), rows.size(), cells, 0, 0, actions.size() * sizeof(int32_t), 0};
+    return actions;
+}
+
+// Replace the cells of an action table (one row per non-terminal, num_terminals columns) with
+// expansion chains where a cell starts more than one expansion. The chains are appended to
+// productions (names give their text); returns how many were added.
+inline uint32_t zll1_expansion_chains(std::vector<ZLL1ActionRow> &rows, uint32_t num_terminals,
+                                      std::vector<ZLL1SourceProduction> &productions,
+                                      const std::vector<std::string> &symbols, ZLL1ChainStats *stats) {
+    const std::vector<ZLL1ActionRow> table = rows;
+    const size_t grammar_productions = productions.size();
+    std::map<std::pair<int32_t, std::vector<int32_t>>, int32_t> chain_index;
+    ZLL1ChainStats counts = {0, 0, 0, 0};
+    std::vector<int32_t> stack;
+
+    for (size_t r = 0; r < rows.size(); r++) {
+        int32_t lhs = (int32_t)(num_terminals + r);
+        for (auto &cell : rows[r]) {
+            // run the driver's expansions on a stack holding only lhs (top at the back)
+            stack.assign(1, lhs);
+            size_t expansions = 0;
+            while (!stack.empty() && expansions < ZLL1_MAX_CHAIN_EXPANSIONS) {
+                int32_t top = stack.back();
+                if (top < (int32_t)num_terminals) break;
+                int32_t production = zll1_row_action(table[top - num_terminals], cell.first);
+                if (production == ZLL1_NO_PRODUCTION) break;
+                stack.pop_back();
+                const std::vector<int32_t> &rhs = productions[production].rhs;
+                stack.insert(stack.end(), rhs.rbegin(), rhs.rend());
+                expansions++;
+            }
+            if (expansions < 2) continue;
+
+            std::vector<int32_t> rhs(stack.rbegin(), stack.rend());
+            auto inserted = chain_index.emplace(std::make_pair(lhs, rhs), (int32_t)productions.size());
+            if (inserted.second) {
+                ZLL1SourceProduction chain;
+                chain.lhs = lhs;
+                for (int32_t symbol : rhs) chain.text += (chain.text.empty() ? "" : " ") + symbols[symbol];
+                if (chain.text.empty()) chain.text = "ε";
+                chain.rhs = std::move(rhs);
+                counts.rhs_symbols += chain.rhs.size();
+                productions.push_back(std::move(chain));
+            }
+            cell.second = inserted.first->second;
+            counts.cells++;
+            counts.expansions += expansions;
+        }
+    }
+
+    counts.chains = productions.size() - grammar_productions;
+    if (stats) *stats = counts;
+    return (uint32_t)counts.chains;
+}
+
+// FNV-1a over the cells of an action row, to find identical rows without comparing them all
+inline uint64_t zll1_row_hash(const ZLL1ActionRow &row) {
+    uint64_t h = 14695981039346656037ull;
+    for (const auto &cell : row) {
+        h = (h ^ cell.first) * 1099511628211ull;
+        h = (h ^ (uint32_t)cell.second) * 1099511628211ull;
+    }
+    return h;
+}
+
+// Compress an action table (rows of columns cells) into the ZLL1CompressedActions section, as
+// 32-bit words. Merged rows are placed first-fit, the ones with the most cells first.
+inline std::vector<int32_t> zll1_compress_actions(const std::vector<ZLL1ActionRow> &rows, uint32_t columns,
+                                                  bool defaults, ZLL1CompressionStats *stats) {
+    // Merge identical rows; only rows with the same hash are compared, in place
+    std::unordered_map<uint64_t, std::vector<int32_t>> row_buckets;
+    std::vector<int32_t> row_of(rows.size());
+    std::vector<const ZLL1ActionRow *> merged;
+    for (size_t r = 0; r < rows.size(); r++) {
+        std::vector<int32_t> &bucket = row_buckets[zll1_row_hash(rows[r])];
+        int32_t m = -1;
+        for (int32_t candidate : bucket) {
+            if (*merged[candidate] == rows[r]) {
+                m = candidate;
+                break;
+            }
+        }
+        if (m < 0) {
+            m = (int32_t)merged.size();
+            merged.push_back(&rows[r]);
+            bucket.push_back(m);
+        }
+        row_of[r] = m;
+    }
+    row_buckets.clear();
+
+    // Default production of each merged row; the comb gets the other cells
+    size_t num_rows = merged.size();
+    std::vector<int32_t> row_defaults(num_rows, ZLL1_NO_PRODUCTION);
+    std::vector<size_t> comb_cells(num_rows);
+    size_t cells = 0, comb_entries = 0;
+    for (size_t m = 0; m < num_rows; m++) {
+        if (defaults) {
+            std::map<int32_t, uint32_t> counts;
+            for (const auto &cell : *merged[m]) counts[cell.second]++;
+            uint32_t best = 0;
+            for (const auto &count : counts) {
+                if (count.second > best) {
+                    best = count.second;
+                    row_defaults[m] = count.first;
+                }
+            }
+        }
+        for (const auto &cell : *merged[m]) comb_cells[m] += cell.second != row_defaults[m];
+        comb_entries += comb_cells[m];
+    }
+    for (const ZLL1ActionRow &row : rows) cells += row.size();
+
+    // Row displacement: busiest rows first, each at the lowest base where its cells are free
+    std::vector<size_t> order(num_rows);
+    for (size_t m = 0; m < num_rows; m++) order[m] = m;
+    std::stable_sort(order.begin(), order.end(), [&comb_cells](size_t a, size_t b) {
+        return comb_cells[a] > comb_cells[b];
+    });
+    std::vector<int32_t> row_base(num_rows, 0);
+    std::vector<ZLL1CombEntry> comb;
+    size_t first_free = 0;
+    for (size_t m : order) {
+        if (comb_cells[m] == 0) continue;
+        const ZLL1ActionRow &row = *merged[m];
+        const int32_t row_default = row_defaults[m];
+        uint32_t first_column = 0;
+        for (const auto &cell : row) {
+            if (cell.second != row_default) {
+                first_column = cell.first;
+                break;
+            }
+        }
+        size_t base = first_free > first_column ? first_free - first_column : 0;
+        for (;; base++) {
+            bool fits = true;
+            for (const auto &cell : row) {
+                if (cell.second != row_default && base + cell.first < comb.size() && comb[base + cell.first].row >= 0) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) break;
+        }
+        if (comb.size() < base + columns) comb.resize(base + columns, {ZLL1_NO_PRODUCTION, -1});
+        for (const auto &cell : row) {
+            if (cell.second != row_default) comb[base + cell.first] = {cell.second, (int32_t)m};
+        }
+        row_base[m] = (int32_t)base;
+        while (first_free < comb.size() && comb[first_free].row >= 0) first_free++;
+    }
+    if (comb.size() < columns) comb.resize(columns, {ZLL1_NO_PRODUCTION, -1});
+
+    std::vector<int32_t> section = {(int32_t)num_rows, (int32_t)comb.size()};
+    section.insert(section.end(), row_of.begin(), row_of.end());
+    section.insert(section.end(), row_base.begin(), row_base.end());
+    section.insert(section.end(), row_defaults.begin(), row_defaults.end());
+    for (const ZLL1CombEntry &entry : comb) {
+        section.push_back(entry.production);
+        section.push_back(entry.row);
+    }
+
+    if (stats) {
+        stats->rows = rows.size();
+        stats->merged_rows = num_rows;
+        stats->cells = cells;
+        stats->comb_entries = comb_entries;
+        stats->comb_size = comb.size();
+        stats->dense_bytes = rows.size() * columns * sizeof(int32_t);
+        stats->compressed_bytes = section.size() * sizeof(int32_t);
+    }
+    return section;
+}
+
+// Serialize a table into the layout above.
+// symbols: names by ID (terminals first), actions: rows x num_terminals production indices,
+// or a section from zll1_compress_actions with ZLL1_FLAG_COMPRESSED_ACTIONS in flags.
+// The last num_chains productions are expansion chains (ZLL1_FLAG_EXPANSION_CHAINS).
+inline std::vector<char> zll1_build(const std::vector<std::string> &symbols, uint32_t num_terminals,
+                                    int32_t start_symbol, const std::vector<ZLL1SourceProduction> &productions,
+                                    const std::vector<int32_t> &actions, uint32_t flags = 0, uint32_t num_chains = 0) {
+    ZLL1Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ZLL1_MAGIC;
+    header.version = ZLL1_VERSION;
+    header.flags = flags;
+    header.num_symbols = (uint32_t)symbols.size();
+    header.num_terminals = num_terminals;
+    header.num_productions = (uint32_t)(productions.size() - num_chains);
+    header.num_chains = num_chains;
+    header.start_symbol = start_symbol;
+    header.hash_buckets = 16;
+    while (header.hash_buckets < 2 * header.num_symbols + 1) header.hash_buckets *= 2;
+
+    // String pool: names, then production texts, each NUL-terminated
+    std::string strings;
+    std::vector<ZLL1Symbol> symbol_records;
+    for (const std::string &name : symbols) {
+        symbol_records.push_back({(uint32_t)strings.size(), (uint32_t)name.size()});
+        strings.append(name).push_back('\0');
+    }
+    std::vector<ZLL1Production> production_records;
+    std::vector<int32_t> rhs;
+    for (const ZLL1SourceProduction &p : productions) {
+        production_records.push_back({p.lhs, (uint32_t)rhs.size(), (uint32_t)p.rhs.size(), (uint32_t)strings.size()});
+        rhs.insert(rhs.end(), p.rhs.rbegin(), p.rhs.rend());
+        strings.append(p.text).push_back('\0');
+    }
+
+    std::vector<int32_t> hash(header.hash_buckets, -1);
+    for (size_t id = 0; id < symbols.size(); id++) {
+        uint32_t b = zll1_hash(symbols[id].data(), symbols[id].size()) & (header.hash_buckets - 1);
+        while (hash[b] >= 0) b = (b + 1) & (header.hash_buckets - 1);
+        hash[b] = (int32_t)id;
+    }
+
+    size_t offset = zll1_align(sizeof(ZLL1Header));
+    header.symbols_offset = offset;
+    offset = zll1_align(offset + symbol_records.size() * sizeof(ZLL1Symbol));
+    header.strings_offset = offset;
+    header.strings_size = strings.size();
+    offset = zll1_align(offset + strings.size());
+    header.hash_offset = offset;
+    offset = zll1_align(offset + hash.size() * sizeof(int32_t));
+    header.actions_offset = offset;
+    offset = zll1_align(offset + actions.size() * sizeof(int32_t));
+    header.productions_offset = offset;
+    offset = zll1_align(offset + production_records.size() * sizeof(ZLL1Production));
+    header.rhs_offset = offset;
+    header.rhs_count = rhs.size();
+    offset = zll1_align(offset + rhs.size() * sizeof(int32_t));
+    header.file_size = offset;
+
+    std::vector<char> image(offset, 0);
+    auto put = [&image](uint64_t at, const void *data, size_t bytes) {
+        if (bytes != 0) memcpy(image.data() + at, data, bytes);
+    };
+    put(0, &header, sizeof(header));
+    put(header.symbols_offset, symbol_records.data(), symbol_records.size() * sizeof(ZLL1Symbol));
+    put(header.strings_offset, strings.data(), strings.size());
+    put(header.hash_offset, hash.data(), hash.size() * sizeof(int32_t));
+    put(header.actions_offset, actions.data(), actions.size() * sizeof(int32_t));
+    put(header.productions_offset, production_records.data(), production_records.size() * sizeof(ZLL1Production));
+    put(header.rhs_offset, rhs.data(), rhs.size() * sizeof(int32_t));
+    return image;
+}
+
+#endif // ZETA_PARSE_TABLE_FORMAT_H
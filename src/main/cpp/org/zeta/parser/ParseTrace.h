@@ -0,0 +1,74 @@
+//
+// Binary parse traces written by Stack.cpp and pretty-printed by TraceDump.cpp.
+//
+// In per-step trace mode the driver stores one fixed-size record per step in an
+// in-memory ring buffer instead of formatting text. When a parse fails (and once
+// more at exit) the records are appended to a trace file, which starts with a copy
+// of the compiled parsing table so it can be decoded without the original files.
+//
+// File layout:
+//   TraceFileHeader
+//   char          table[table_size]      ZLL1 image (ParseTableFormat.h)
+//   then any number of segments:
+//     TraceSegmentHeader
+//     TraceRecord records[record_count]
+//
+#ifndef ZETA_PARSE_TRACE_H
+#define ZETA_PARSE_TRACE_H
+
+#include <stdint.h>
+
+#define ZTRC_MAGIC 0x4352545Au /* "ZTRC" */
+#define ZTRC_VERSION 1
+
+// Outcome of one parse
+typedef enum {
+    PARSE_ACCEPTED = 0,
+    PARSE_NO_PRODUCTION = 1,     // empty table cell (or a terminal on the stack that does not match)
+    PARSE_INPUT_REMAINING = 2,   // stack reduced to $ before the end of the line
+    PARSE_STACK_REMAINING = 3,   // end of the line before the stack was reduced to $
+} ParseStatus;
+
+typedef enum {
+    TRACE_BEGIN = 1,     // top = start symbol, arg = input line number
+    TRACE_EXPAND = 2,    // arg = production
+    TRACE_MATCH = 3,
+    TRACE_ACCEPT = 4,
+    TRACE_ERROR = 5,     // arg = ParseStatus of the failure
+    TRACE_END = 6,       // arg = ParseStatus of the parse
+} TraceKind;
+
+typedef struct {
+    uint32_t step;
+    int32_t top;         // stack top before the action
+    int32_t lookahead;   // lookahead terminal ID, -1 if the token is not a known symbol
+    int32_t arg;
+    uint16_t kind;       // TraceKind
+    uint16_t reserved;
+    uint32_t depth;      // stack depth before the action
+} TraceRecord;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t table_size;
+} TraceFileHeader;
+
+typedef struct {
+    uint64_t record_count;
+    uint64_t dropped;    // records before the first one that were lost to ring wrap-around
+} TraceSegmentHeader;
+
+// Fixed-capacity ring of trace records; capacity is a power of two
+typedef struct {
+    TraceRecord *records;
+    uint64_t capacity;
+    uint64_t head;       // total records ever written
+} TraceRing;
+
+inline void trace_ring_push(TraceRing *ring, const TraceRecord &record) {
+    ring->records[ring->head & (ring->capacity - 1)] = record;
+    ring->head++;
+}
+
+#endif // ZETA_PARSE_TRACE_H
@@ -1,876 +1,271 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <vector>
-#include <map>
-#include <set>
-#include <algorithm>
-#include <iomanip>
 #include <string>
-#include <sstream>
-
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Grammar.h"
+#include "AnalysisCache.h"
+#include "GrammarExport.h"
+#include "ParseDriver.h"
 
 using namespace std;
 
-// Helper function to tokenize a production string into symbols
-vector<string> tokenizeProduction(const string& prod) {
-    vector<string> tokens;
-    // Trim leading/trailing whitespace before tokenizing
-    string trimmedProd = prod;
-    size_t first = trimmedProd.find_first_not_of(" \t");
-    if (string::npos == first) return tokens; // Empty or whitespace only
-    size_t last = trimmedProd.find_last_not_of(" \t");
-    trimmedProd = trimmedProd.substr(first, (last - first + 1));
-
-    istringstream iss(trimmedProd);
-    string token;
-    while (iss >> token) {
-        tokens.push_back(token);
-    }
-    return tokens;
-}
-
-// Helper function to join tokens back into a string
-string joinTokens(const vector<string>& tokens, size_t start = 0, size_t end = string::npos) {
-    string result = "";
-    if (end == string::npos) {
-        end = tokens.size();
-    }
-    for (size_t i = start; i < end; ++i) {
-        if (i > start) {
-            result += " ";
-        }
-        result += tokens[i];
-    }
-    return result;
-}
-
-
-// class to assist in console output redirection to file
+// class to assist in console output redirection to file. Output collects in a put area and
+// is handed to both streams with one sputn each when the area fills up or the stream is
+// flushed; only the console is synced on flush, the file side is flushed when it is closed.
 class TeeBuf : public streambuf {
 public:
     // initializes two streaming buffers
-    TeeBuf(streambuf* sb1, streambuf* sb2) : sb1_(sb1), sb2_(sb2) {}
+    TeeBuf(streambuf* sb1, streambuf* sb2) : sb1_(sb1), sb2_(sb2) {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    ~TeeBuf() override { drain(); }
 
 protected:
 
-    // write the character c to both output streams
+    // the put area is full: pass it on, then start the next one with c
     int overflow(int c) override {
-        if (c == EOF) {
-            return !EOF;
-        }
-        else {
-            int r1 = sb1_->sputc(c);
-            int r2 = sb2_->sputc(c);
-            return (r1 == EOF || r2 == EOF) ? EOF : c;
+        if (drain() != 0) return EOF;
+        if (c == EOF) return !EOF;
+        *pptr() = (char)c;
+        pbump(1);
+        return c;
+    }
+
+    // copy into the put area; text that would not fit even in an empty one goes straight through
+    streamsize xsputn(const char* s, streamsize n) override {
+        if (n > epptr() - pptr()) {
+            if (drain() != 0) return 0;
+            if (n >= (streamsize)sizeof(buffer_)) {
+                streamsize r1 = sb1_->sputn(s, n);
+                streamsize r2 = sb2_->sputn(s, n);
+                return min(r1, r2);
+            }
         }
+        memcpy(pptr(), s, (size_t)n);
+        pbump((int)n);
+        return n;
     }
 
-    // flush both output streams
+    // write out the put area and flush the console
     int sync() override {
-        int r1 = sb1_->pubsync();
-        int r2 = sb2_->pubsync();
+        int r1 = drain();
+        int r2 = sb1_->pubsync();
         return (r1 == 0 && r2 == 0) ? 0 : -1;
     }
 
 private:
+    // write the put area to both output streams and empty it
+    int drain() {
+        streamsize n = pptr() - pbase();
+        if (n == 0) return 0;
+        streamsize r1 = sb1_->sputn(pbase(), n);
+        streamsize r2 = sb2_->sputn(pbase(), n);
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return (r1 == n && r2 == n) ? 0 : -1;
+    }
+
     streambuf* sb1_;
     streambuf* sb2_;
+    char buffer_[1 << 14];
 };
 
-// Class to store and process Context-Free Grammar (CFG)
-class Grammar {
+// streambuf handing everything written to it to a background thread that writes it to target,
+// so the log costs the writing thread a copy under a lock (Parser --async-log)
+class AsyncLogWriter : public streambuf {
 public:
-    // Map to store the original cfg
-    map<string, vector<string>> cfg;
-
-    // Maps to store first and follow sets
-    map<string, set<string>> first;
-    map<string, set<string>> follow;
-
-    // Sets of terminals and non-terminals
-    set<string> nonTerminals;
-    set<string> terminals;
-
-    // map to hold the parsing table
-    map<pair<string, string>, string> parsingTable;
-
-
-    // Default constructor
-    Grammar() = default;
-
-    // Function to read grammar from a file
-    int readGrammar(const string& fileName) {
-        string line;
-
-        // File opening validation
-        ifstream file(fileName);
-        if (!file) {
-            cerr << "Error: Could not open file." << endl;
-            return 0;
-        }
-
-        // Read each line of the file
-        while (getline(file, line)) {
-            // Read one line of the cfg (a production rule) into a string stream
-            istringstream iss(line);
-            string lhs, arrow, rhs;
-
-            // Extract non-terminal on the Left hand side into lhs, and the arrow "->" into arrow
-            iss >> lhs >> arrow;
-
-            // Production format validation
-            if (arrow != "->") {
-                cerr << "Error: Invalid production format." << endl;
-                return 0;
-            }
-
-            // Extract right-hand side (actual productions) into rhs
-            getline(iss, rhs);
-
-            // Read the rhs of the cfg into a string stream
-            istringstream rhsStream(rhs);
-            string production;
-
-            // Split productions by '|' and store them in the map
-            while (getline(rhsStream, production, '|')) { cfg[lhs].push_back(production); }
-
-        }
-
-        file.close();
-        return 1;
-    }
-
-    // Function to print the CFG
-    void printGrammar() {
-        for (const auto& rule : cfg) {
-            // Print non-terminal of rule
-            cout << rule.first << " -> ";
-            for (size_t i = 0; i < rule.second.size(); ++i) {
-                // Print right-hand side productions
-                cout << rule.second[i];
-                // Separate multiple productions
-                if (i < rule.second.size() - 1) cout << " | ";
-            }
-            cout << endl;
-        }
-    }
-
-    // Function that applies left factoring to the CFG
-    int leftFactoring() {
-        bool changed = true;
-        // counter for new unique non-terminals
-        int newSymbolCount = 0;
-
-        // Iterate until no changes are made in an iteration
-        while (changed) {
-            changed = false;
-            map<string, vector<string>> new_cfg;
-
-            // Iterate over the CFG
-            for (auto const& [lhs, productions] : cfg) { // Use structured binding
-                vector<string> currentProductions = productions; // Work on a copy
-
-                // Continue factoring until no more changes can be made for this non-terminal
-                bool localChanged = true;
-                while (localChanged && currentProductions.size() > 1) {
-                    localChanged = false;
-
-                    // finding longest common prefix among the productions (TOKEN BASED)
-                    for (size_t i = 0; i < currentProductions.size(); ++i) {
-                        vector<string> tokens_i = tokenizeProduction(currentProductions[i]);
-                        if (tokens_i.empty()) continue; // Skip empty productions
-
-                        vector<size_t> commonGroupIndices; // Indices of productions sharing the longest prefix with prod i
-                        vector<string> longestPrefixTokens; // The longest common token prefix found so far for prod i
-
-                        // Compare current production (i) with subsequent productions (j)
-                        for (size_t j = i + 1; j < currentProductions.size(); ++j) {
-                            vector<string> tokens_j = tokenizeProduction(currentProductions[j]);
-                            if (tokens_j.empty()) continue;
-
-                            size_t k = 0; // Length of current common token prefix
-                            while (k < tokens_i.size() && k < tokens_j.size() && tokens_i[k] == tokens_j[k]) {
-                                k++;
-                            }
-
-                            // Check if this common prefix is longer than the current longestPrefixTokens
-                            if (k > 0 && k >= longestPrefixTokens.size()) {
-                                vector<string> currentPrefixTokens(tokens_i.begin(), tokens_i.begin() + k);
-
-                                // If strictly longer, reset the group
-                                if (k > longestPrefixTokens.size()) {
-                                    longestPrefixTokens = currentPrefixTokens;
-                                    commonGroupIndices.clear();
-                                    commonGroupIndices.push_back(j); // Add j to the new group
-                                }
-                                // If equal length, add j to the existing group
-                                else if (k == longestPrefixTokens.size()) {
-                                     // Only add if the prefix actually matches the current longest
-                                    bool prefixMatches = true;
-                                    for(size_t p=0; p<k; ++p) {
-                                        if (tokens_i[p] != longestPrefixTokens[p]) {
-                                            prefixMatches = false;
-                                            break;
-                                        }
-                                    }
-                                    if (prefixMatches) {
-                                        commonGroupIndices.push_back(j);
-                                    }
-                                }
-                            }
-                        } // End comparison loop (j)
-
-                        // If a common prefix was found for production i and at least one other production
-                        if (!longestPrefixTokens.empty() && !commonGroupIndices.empty()) {
-                            localChanged = changed = true; // Mark that changes were made
-
-                            string newNonTerminal = lhs + "_" + to_string(++newSymbolCount);
-                            string prefixStr = joinTokens(longestPrefixTokens);
-
-                            vector<string> newNonTerminalProductions; // Productions for the new non-terminal S'
-                            vector<string> remainingProductions; // Productions that didn't share the prefix
-
-                            // Process the original production 'i' which started the group
-                            vector<string> suffix_i_tokens(tokens_i.begin() + longestPrefixTokens.size(), tokens_i.end());
-                            string suffix_i_str = joinTokens(suffix_i_tokens);
-                            if (suffix_i_str.empty()) suffix_i_str = "ε"; // Use epsilon if suffix is empty
-                            newNonTerminalProductions.push_back(suffix_i_str);
-
-                            // Keep track of indices processed in this factoring step
-                            set<size_t> processedIndices;
-                            processedIndices.insert(i);
-                            for (size_t idx : commonGroupIndices) {
-                                processedIndices.insert(idx);
-                            }
-
-                            // Process productions in the common group (found in commonGroupIndices)
-                            for (size_t idx : commonGroupIndices) {
-                                vector<string> tokens_idx = tokenizeProduction(currentProductions[idx]);
-                                vector<string> suffix_idx_tokens(tokens_idx.begin() + longestPrefixTokens.size(), tokens_idx.end());
-                                string suffix_idx_str = joinTokens(suffix_idx_tokens);
-                                if (suffix_idx_str.empty()) suffix_idx_str = "ε";
-                                newNonTerminalProductions.push_back(suffix_idx_str);
-                            }
-
-                            // Add the new factored production for the original non-terminal
-                            remainingProductions.push_back(prefixStr + " " + newNonTerminal);
-
-                            // Add back any productions that were not part of this factoring group
-                            for (size_t k = 0; k < currentProductions.size(); ++k) {
-                                if (processedIndices.find(k) == processedIndices.end()) {
-                                    remainingProductions.push_back(currentProductions[k]);
-                                }
-                            }
-
-                            // Update the productions for the current non-terminal
-                            currentProductions = remainingProductions;
-                            // Add the new rule for the newly created non-terminal
-                            new_cfg[newNonTerminal] = newNonTerminalProductions;
-
-                            // Restart the check for the current non-terminal since its productions changed
-                            goto next_iteration_for_lhs; // Use goto for clarity in restarting the outer loop check
-                        }
-                    } // End production loop (i)
-
-                    next_iteration_for_lhs:; // Label for restarting the check for the current lhs
-                } // End while(localChanged)
-
-                // Add the final set of productions for this non-terminal to the new grammar
-                // Only add if it wasn't added during factoring (e.g., new non-terminals)
-                 if (new_cfg.find(lhs) == new_cfg.end()) {
-                    new_cfg[lhs] = currentProductions;
-                 } else {
-                    // If lhs was already added (e.g. as a new non-terminal name), merge productions carefully
-                    // This case should ideally not happen with unique naming, but handle defensively
-                    vector<string>& existingProds = new_cfg[lhs];
-                    existingProds.insert(existingProds.end(), currentProductions.begin(), currentProductions.end());
-                 }
-
-
-            } // End CFG iteration
-
-            // replace old cfg with new left factored updated cfg
-            cfg = new_cfg;
-        } // End while(changed)
-
-        // success
-        return 1;
-    }
-
-    // Function to remove left recursion in productions
-    int leftRecursion() {
-        // map to store updated cfg
-        map<string, vector<string>> new_cfg;
-
-        // Iterate over the CFG
-        for (const auto& rule : cfg) {
-            string lhs = rule.first;
-            vector<string> productions = rule.second;
-
-            // vectors to separate valid and left recursive (invalid) productions
-            vector<string> leftRecursiveProds;
-            vector<string> nonLeftRecursiveProds;
-
-            // iterate over each production in the cfg
-            for (const string& prod : productions) {
-
-                // check if the production starts with the same non-terminal
-                istringstream iss(prod);
-                string firstSymbol;
-                iss >> firstSymbol;
-
-                if (firstSymbol == lhs) {
-                    // store the part after the recursive symbol
-                    string alpha;
-                    getline(iss, alpha);
-                    // add the invalid production to LR productions vector
-                    leftRecursiveProds.push_back(alpha);
-                }
-                else {
-                    // add valid producion to valid set
-                    nonLeftRecursiveProds.push_back(prod);
-                }
-            }
-
-            // If there are no left-recursive productions, keep the original rule
-            if (leftRecursiveProds.empty()) {
-                new_cfg[lhs] = productions;
-                continue;
-            }
-
-            // Create a new non-terminal for the LR non-terminal
-            string newNonTerminal = lhs + "'";
-
-            // Create new productions
-            vector<string> newLhsProds;
-            vector<string> newNonTerminalProds;
+    explicit AsyncLogWriter(streambuf* target) : target_(target), worker_([this] { run(); }) {}
 
-            // If there are no valid productions, add epsilon to avoid empty rule
-            if (nonLeftRecursiveProds.empty()) { nonLeftRecursiveProds.emplace_back("ε"); }
+    ~AsyncLogWriter() override { finish(); }
 
-            // Create productions for A -> β A'
-            for (const string& beta : nonLeftRecursiveProds) {
-                string newProd = beta;
-
-                // Don't append the new non-terminal to epsilon
-                if (newProd != "ε") { newProd += " " + newNonTerminal; }
-                else { newProd = newNonTerminal; }
-
-                newLhsProds.push_back(newProd);
-            }
-
-            // Create productions for A' -> α A' | ε
-            for (const string& alpha : leftRecursiveProds) {
-                string newProd = alpha + " " + newNonTerminal;
-                newNonTerminalProds.push_back(newProd);
-            }
-
-            // Add epsilon production for A'
-            newNonTerminalProds.push_back("ε");
-
-            // Update the grammar
-            new_cfg[lhs] = newLhsProds;
-            new_cfg[newNonTerminal] = newNonTerminalProds;
-        }
-
-        // Replace old grammar with new one
-        cfg = new_cfg;
-        return 1;
-    }
-
-    // identify all terminals and non-terminals in the grammar and store them
-    void initializeSymbols() {
-        nonTerminals.clear();
-        terminals.clear();
-
-        // add all LHS symbols to non-terminal set
-        for (const auto& rule : cfg) {
-            nonTerminals.insert(rule.first);
-        }
-
-        // Find terminals
-        for (const auto& rule : cfg) {
-            for (const string& prod : rule.second) {
-                istringstream iss(prod);
-                string token;
-
-                while (iss >> token) {
-                    // if it is not in non-terminal set and is not epislon, it is a terminal
-                    if (token != "ε" && nonTerminals.find(token) == nonTerminals.end()) { terminals.insert(token); }
-                }
-            }
-        }
-    }
-
-    // function to make FIRST set for all non-terminals
-    int computeFirst() {
-        initializeSymbols();
-
-        // Initialize first sets
-        first.clear();
-        for (const string& nonTerm : nonTerminals) {
-            first[nonTerm] = {};
-        }
-        // Initialize first sets for terminals as well, needed for computeFirstOfProduction
-        for (const string& term : terminals) {
-            first[term] = {term};
-        }
-        // Add epsilon explicitly if needed later
-        first["ε"] = {"ε"};
-
-
-        bool changed = true;
-        // iterate until no changes in an iteration
-        while (changed) {
-            changed = false;
-
-            // iterate over the cfg
-            for (const auto& rule : cfg) {
-                string lhs = rule.first;
-
-                // iterate over each production of a rule
-                for (const string& prodStr : rule.second) {
-                    vector<string> prod = tokenizeProduction(prodStr); // Tokenize production
-
-                    // Handle direct epsilon production: X -> ε
-                    if (prod.empty() || (prod.size() == 1 && prod[0] == "ε")) {
-                         if (first[lhs].insert("ε").second) changed = true;
-                         continue;
-                    }
-
-
-                    // compute First for this production X -> Y1 Y2 ... Yk
-                    // flag to track if all symbols in production can derive ε
-                    bool allDeriveEpsilon = true;
-
-                    for (const auto & symbol : prod) {
-                        // Ensure the symbol exists in the first map (could be terminal or non-terminal)
-                        if (first.find(symbol) == first.end()) {
-                             // This case should ideally not happen if initializeSymbols is correct
-                             // If it's a terminal not seen before, its first set is itself
-                             if (terminals.count(symbol)) {
-                                first[symbol] = {symbol};
-                             } else {
-                                // Or handle as an error / unknown symbol
-                                cerr << "Warning: Symbol '" << symbol << "' in production '" << prodStr << "' not found in FIRST sets." << endl;
-                                allDeriveEpsilon = false; // Cannot proceed if symbol is unknown
-                                break;
-                             }
-                        }
-
-                        // flag to track if current symbol derives an epsilon
-                        bool currDerivedEpsilon = false;
-
-                        // Add all elements from First(symbol) except epsilon to First(lhs)
-                        for (const string& elem : first[symbol]) {
-                            if (elem == "ε") currDerivedEpsilon = true;
-                            else {
-                                // mark change if it's a new addition
-                                if (first[lhs].insert(elem).second) changed = true;
-                            }
-                        }
-
-                        // if this symbol cannot derive epsilon, stop processing more symbols
-                        if (!currDerivedEpsilon) {
-                            allDeriveEpsilon = false;
-                            break;
-                        }
-                    }
-
-                    // If all symbols of the production can derive epsilon, add epsilon to First(lhs)
-                    if (allDeriveEpsilon) {
-                        if (first[lhs].insert("ε").second) changed = true;
-                    }
-                }
-            }
-        }
-
-        return 1;
-    }
-
-
-    // Helper function to compute First of a sequence of symbols (production RHS)
-    // Returns true if the sequence can derive epsilon, false otherwise.
-    // Populates firstSet with the First set of the sequence.
-    bool computeFirstOfSequence(const vector<string>& symbols, set<string>& firstSet) {
-        firstSet.clear();
-        bool allDeriveEpsilon = true;
-
-        if (symbols.empty() || (symbols.size() == 1 && symbols[0] == "ε")) {
-             firstSet.insert("ε");
-             return true; // Epsilon sequence derives epsilon
-        }
-
-
-        for (const auto & symbol : symbols) {
-            // Ensure the symbol exists in the first map
-            if (first.find(symbol) == first.end()) {
-                 if (terminals.count(symbol)) {
-                    first[symbol] = {symbol}; // Handle terminals on the fly if missed
-                 } else {
-                    cerr << "Warning: Symbol '" << symbol << "' not found in FIRST sets during FirstOfSequence calculation." << endl;
-                    allDeriveEpsilon = false;
-                    break;
-                 }
-            }
-
-            bool currDerivedEpsilon = false;
-            for (const string& elem : first[symbol]) {
-                if (elem == "ε") {
-                    currDerivedEpsilon = true;
-                } else {
-                    firstSet.insert(elem);
-                }
-            }
-
-            if (!currDerivedEpsilon) {
-                allDeriveEpsilon = false;
-                break; // Stop if a symbol doesn't derive epsilon
-            }
+    // write out everything queued so far, stop the thread and flush target
+    void finish() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            done_ = true;
         }
-
-        // If all symbols derived epsilon, add epsilon to the result set
-        if (allDeriveEpsilon) {
-            firstSet.insert("ε");
+        ready_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+            target_->pubsync();
         }
-
-        return allDeriveEpsilon; // Return whether the whole sequence can derive epsilon
     }
 
-
-    // function to make FOLLOW set for all non-terminals
-    int computeFollow() {
-
-        // Ensure FIRST sets are computed
-        if (first.empty()) {
-            computeFirst();
-        }
-         // Ensure symbols are initialized
-        if (nonTerminals.empty() || terminals.empty()) {
-            initializeSymbols();
-        }
-
-
-        // initialize Follow sets
-        follow.clear();
-        for (const string& nonTerm : nonTerminals) follow[nonTerm] = {};
-
-        // Rule 1: Add $ to Follow of the designated start symbol
-        // *** MODIFIED: Explicitly use "P" as the start symbol for this grammar ***
-        string startSymbol = "P";
-        if (nonTerminals.count(startSymbol)) { // Check if P exists
-            follow[startSymbol].insert("$");
-        } else {
-             // Fallback or error if P is not found (should not happen with the given grammar)
-             string firstKey = cfg.begin()->first;
-             if (!firstKey.empty()) {
-                 follow[firstKey].insert("$");
-                 cerr << "Warning: Explicit start symbol 'P' not found. Using first rule's LHS: '" << firstKey << "' as start symbol." << endl;
-             } else {
-                 cerr << "Error: Cannot determine start symbol." << endl;
-                 return 0; // Cannot proceed without a start symbol
-             }
-        }
-
-
-        bool changed = true;
-        // iterate until no changes in an iteration
-        while (changed) {
-            changed = false;
-
-            // Iterate over rules in the CFG: A -> α
-            for (const auto& rule : cfg) {
-                string lhs_A = rule.first;
-
-
-                for (const string& prodStr : rule.second) {
-                    vector<string> prod = tokenizeProduction(prodStr); // Tokenize production α
-
-                    // Iterate over each symbol B in the production α
-                    for (size_t i = 0; i < prod.size(); ++i) {
-                        string symbol_B = prod[i];
-
-                        // We only compute Follow for non-terminals
-                        if (nonTerminals.find(symbol_B) == nonTerminals.end()) continue;
-
-                        // Consider the part of the production after B: β
-                        // Create a vector for β (symbols from i+1 to end)
-                        vector<string> beta_sequence;
-                        if (i + 1 < prod.size()) {
-                            beta_sequence.assign(prod.begin() + i + 1, prod.end());
-                        }
-
-                        // Rule 2: A -> α B β
-                        // Add First(β) - {ε} to Follow(B)
-                        set<string> firstOfBeta;
-                        bool betaDerivesEpsilon = computeFirstOfSequence(beta_sequence, firstOfBeta); // Use helper
-
-                        for (const string& term : firstOfBeta) {
-                            if (term != "ε") {
-                                if (follow[symbol_B].insert(term).second) changed = true;
-                            }
-                        }
-
-                        // Rule 3: A -> α B or A -> α B β where First(β) contains ε
-                        // Add Follow(A) to Follow(B)
-                        if (beta_sequence.empty() || betaDerivesEpsilon) {
-                            for (const string& term : follow[lhs_A]) {
-                                if (follow[symbol_B].insert(term).second) changed = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        return 1;
+protected:
+    int overflow(int c) override {
+        if (c == EOF) return !EOF;
+        char ch = (char)c;
+        xsputn(&ch, 1);
+        return c;
     }
 
-    // function to print First and Follow sets
-    void printFirstAndFollow() {
-        cout << "\nFirst Sets:" << endl;
-        // iterate over all non-terminals and print items of each non-terminal's first set
-        // Sort non-terminals for consistent output
-        vector<string> sortedNonTerminals(nonTerminals.begin(), nonTerminals.end());
-        sort(sortedNonTerminals.begin(), sortedNonTerminals.end());
-
-        for (const auto& nonTerm : sortedNonTerminals) {
-            cout << "First(" << left << setw(max(10, (int)nonTerm.length())) << nonTerm << ") = { ";
-            // Sort terminals within the set for consistent output
-            set<string>& fSet = first[nonTerm];
-            vector<string> sortedFirst(fSet.begin(), fSet.end());
-            sort(sortedFirst.begin(), sortedFirst.end());
-            string sep = "";
-            for (const auto& term : sortedFirst) {
-                 cout << sep << term;
-                 sep = ", ";
-            }
-            cout << " }" << endl;
-        }
-
-
-        cout << "\nFollow Sets:" << endl;
-        // iterate over all non-terminals and print items of each non-terminal's follow set
-        for (const auto& nonTerm : sortedNonTerminals) {
-            cout << "Follow(" << left << setw(max(10, (int)nonTerm.length())) << nonTerm << ") = { ";
-             // Sort terminals within the set for consistent output
-            set<string>& flSet = follow[nonTerm];
-            vector<string> sortedFollow(flSet.begin(), flSet.end());
-            sort(sortedFollow.begin(), sortedFollow.end());
-            string sep = "";
-            for (const auto& term : sortedFollow) {
-                cout << sep << term;
-                sep = ", ";
-            }
-            cout << " }" << endl;
+    streamsize xsputn(const char* s, streamsize n) override {
+        {
+            lock_guard<mutex> lock(mutex_);
+            pending_.append(s, (size_t)n);
         }
+        ready_.notify_one();
+        return n;
     }
 
-    int computeParsingTable() {
-        // Make sure First and Follow sets are computed
-        if (first.empty()) computeFirst();
-        if (follow.empty()) computeFollow();
-
-
-        // Clear the existing parsing table
-        parsingTable.clear();
-
-        // Add $ as a terminal for end of input if not already present
-        terminals.insert("$");
-
-        // Iterative over rules in the cfg: A -> α
-        for (const auto& rule : cfg) {
-            string nonTerm_A = rule.first;
-
-            for (const string& prodStr : rule.second) { // α
-                 vector<string> prod_alpha = tokenizeProduction(prodStr);
-
-                // Compute FIRST(α)
-                set<string> firstOfAlpha;
-                bool alphaDerivesEpsilon = computeFirstOfSequence(prod_alpha, firstOfAlpha);
-
-
-                // Rule 1: For each terminal 'a' in FIRST(α), add A -> α to M[A, a]
-                for (const string& term_a : firstOfAlpha) {
-                    if (term_a != "ε") {
-                        pair<string, string> tableKey = make_pair(nonTerm_A, term_a);
-
-                        // Check for conflicts (non-LL(1) grammar)
-                        if (parsingTable.find(tableKey) != parsingTable.end() && parsingTable[tableKey] != prodStr) {
-                            cerr << "\nLL(1) Conflict Detected!" << endl;
-                            cerr << "  At Table[" << nonTerm_A << ", " << term_a << "]:" << endl;
-                            cerr << "  Existing production: " << nonTerm_A << " -> " << parsingTable[tableKey] << endl;
-                            cerr << "  New production:      " << nonTerm_A << " -> " << prodStr << endl;
-                            cerr << "  FIRST(" << prodStr << ") = {";
-                            for(const auto& f : firstOfAlpha) cerr << f << ","; cerr << "}" << endl;
-                            cerr << "  FOLLOW(" << nonTerm_A << ") = {";
-                            for(const auto& f : follow[nonTerm_A]) cerr << f << ","; cerr << "}" << endl;
-                            // Optionally return an error code or throw exception
-                        }
-
-                        // Add the original string production to the parsing table
-                        parsingTable[tableKey] = prodStr;
-                    }
-                }
-
-                // Rule 2: If ε is in FIRST(α), then for each terminal 'b' in FOLLOW(A), add A -> α to M[A, b]
-                if (alphaDerivesEpsilon) { // Check if the whole sequence α can derive ε
-                    for (const string& term_b : follow[nonTerm_A]) { // term_b includes '$' if applicable
-                        pair<string, string> tableKey = make_pair(nonTerm_A, term_b);
-
-                        // Check for conflicts
-                         if (parsingTable.find(tableKey) != parsingTable.end() && parsingTable[tableKey] != prodStr) {
-                            cerr << "\nLL(1) Conflict Detected (Epsilon Rule)!" << endl;
-                            cerr << "  At Table[" << nonTerm_A << ", " << term_b << "]:" << endl;
-                            cerr << "  Existing production: " << nonTerm_A << " -> " << parsingTable[tableKey] << endl;
-                            cerr << "  New production:      " << nonTerm_A << " -> " << prodStr << " (due to FOLLOW set)" << endl;
-                             cerr << "  FIRST(" << prodStr << ") = {";
-                            for(const auto& f : firstOfAlpha) cerr << f << ","; cerr << "}" << endl;
-                            cerr << "  FOLLOW(" << nonTerm_A << ") = {";
-                            for(const auto& f : follow[nonTerm_A]) cerr << f << ","; cerr << "}" << endl;
-                            // Optionally return an error code or throw exception
-                        }
-
-                        // Add the original string production to the parsing table
-                        parsingTable[tableKey] = prodStr;
-                    }
-                }
-            }
+private:
+    // swap out whatever is pending and write it without holding the lock
+    void run() {
+        string chunk;
+        unique_lock<mutex> lock(mutex_);
+        while (true) {
+            ready_.wait(lock, [this] { return done_ || !pending_.empty(); });
+            if (pending_.empty()) return;
+            chunk.swap(pending_);
+            lock.unlock();
+            target_->sputn(chunk.data(), (streamsize)chunk.size());
+            chunk.clear();
+            lock.lock();
         }
-
-        return 1; // Indicate success (though conflicts might have been printed)
     }
 
-    void printParsingTable() {
-        cout << "\nLL(1) Parsing Table:" << endl;
-
-        const int colWidth = 20;
-        map<pair<string, string>, string> truncatedEntries;
-
-        // Top border
-        cout << "+" << string(colWidth, '-');
-        for (const auto& term : terminals) cout << "+" << string(colWidth, '-');
-        cout << "+" << endl;
-
-        // Header row
-        cout << "|" << setw(colWidth) << left << " NT \\ Terminal";
-        for (const auto& term : terminals) cout << "|" << setw(colWidth) << left << term;
-        cout << "|" << endl;
-
-        // Separator line
-        cout << "+" << string(colWidth, '-');
-        for (size_t i = 0; i < terminals.size(); i++) cout << "+" << string(colWidth, '-');
-        cout << "+" << endl;
-
-        // MAIN PARSING TABLE
-        for (const auto& nonTerm : nonTerminals) {
-            cout << "|" << setw(colWidth) << left << nonTerm;
-
-            for (const auto& term : terminals) {
-                pair<string, string> key = { nonTerm, term };
-                string cellContent;
-
-                if (parsingTable.count(key)) {
-                    string production = parsingTable[key];
-
-                    /*
-                    // replace epsilon with ^
-                    size_t pos;
-                    while ((pos = production.find("\u03B5")) != string::npos) production.replace(pos, 2, "^");
-                    */
-
-                    cellContent = nonTerm + " → " + production;
-
-                    // truncation
-                    if (cellContent.length() > colWidth) {
-                        // truncate after the arrow
-                        size_t truncPos = cellContent.find(' ', 10);
-
-                        if (truncPos == string::npos) truncPos = colWidth - 4;
+    streambuf* target_;
+    mutex mutex_;
+    condition_variable ready_;
+    string pending_;
+    bool done_ = false;
+    thread worker_;  // last, so it starts once everything above is constructed
+};
 
-                        truncatedEntries[key] = production;
-                        cellContent = cellContent.substr(0, truncPos) + "...";
-                    }
 
-                }
-                else {
-                    // explicitly pad empty cells with spaces
-                    cellContent = string(colWidth, ' ');
-                }
+// print how many set operations (bit insertions, row unions and copies, counted alike by both
+// solvers) the SCC solver needed compared to whole-grammar sweeps
+void printSolverComparison(const string& name, const SolverStats& scc, const SolverStats& sweep) {
+    long long saved = (long long)sweep.steps - (long long)scc.steps;
+    cout << name << " solver: " << scc.steps << " set operations (" << scc.edges << " edges, "
+         << scc.components << " SCCs); sweeps: " << sweep.steps << " set operations in " << sweep.passes
+         << " passes; saved " << saved << endl;
+}
 
-                cout << "|" << setw(colWidth) << left << cellContent;
-            }
-            cout << "|" << endl;
-        }
+// parse every line of inputFile with a table image and return the step totals of parse_input
+bool countParseSteps(const vector<char>& image, const string& inputFile, ParseTotals& totals) {
+    TokenReader reader;
+    if (!reader_open_file(&reader, inputFile.c_str())) return false;
+    ParsingTable table{};
+    load_parsing_table_image(&table, image.data(), image.size());
+    ParseWorker worker;
+    worker_init(&worker);
+    while (reader_next_line(&reader)) parse_input(&table, &worker, &reader);
+    totals = worker.totals;
+    worker_free(&worker);
+    reader_close(&reader);
+    return true;
+}
 
-        // bottom border
-        cout << "+" << string(colWidth, '-');
-        for (size_t i = 0; i < terminals.size(); i++) cout << "+" << string(colWidth, '-');
-        cout << "+" << endl;
+// expand steps per token: parse_input counts a step per match, per expand and for the final accept
+double expandStepsPerToken(const ParseTotals& totals) {
+    if (totals.tokens == 0) return 0;
+    return (double)(totals.steps - totals.tokens - totals.accepted) / (double)totals.tokens;
+}
 
-        // Key for truncated entries
-        if (!truncatedEntries.empty()) {
-            cout << "\nKey:\n";
-            cout << "* Truncated Entries (full production):\n";
-            for (const auto& entry : truncatedEntries) cout << "  - " << entry.first.first << " → " << entry.second << endl;
-        }
-        cout << "* Empty cells indicate no production\n";
+// apply the edits listed in fileName to an analysed grammar, one per line:
+//   add A -> α | remove A -> α | replace A -> α => β      (blank lines and # comments are skipped)
+bool applyEdits(Grammar& cfg, const string& fileName) {
+    ifstream file(fileName);
+    if (!file) {
+        cerr << "Error: Could not open edit file " << fileName << endl;
+        return false;
     }
-
-    void writeParsingTableToCSV(const string& filename) {
-        ofstream csvFile(filename);
-        if (!csvFile.is_open()) {
-            cerr << "Error: Could not open file " << filename << endl;
-            return;
-        }
-
-        // Write CSV header (terminals)
-        csvFile << "Non-Terminal";
-        for (const auto& term : terminals) csvFile << "," << term;
-        csvFile << "\n";
-
-        // Write rows for each non-terminal
-        for (const auto& nonTerm : nonTerminals) {
-            csvFile << nonTerm; // First column: non-terminal
-
-            for (const auto& term : terminals) {
-                auto key = make_pair(nonTerm, term);
-                string production;
-
-                if (parsingTable.find(key) != parsingTable.end()) {
-                    production = nonTerm + " → " + parsingTable[key];
-
-                    /*
-                    // Replace ε with ^
-                    size_t pos;
-                    while ((pos = production.find("ε")) != string::npos) production.replace(pos, 2, "^");
-                    */
-                }
-
-                csvFile << "," << production;
-            }
-            csvFile << "\n";
+    string line;
+    while (getline(file, line)) {
+        istringstream iss(line);
+        string command, lhs, arrow, rhs;
+        if (!(iss >> command) || command[0] == '#') continue;
+        iss >> lhs >> arrow;
+        getline(iss, rhs);
+        size_t replacement = rhs.find("=>");
+        if (arrow != "->" || (command == "replace") != (replacement != string::npos)) {
+            cerr << "Error: Invalid edit: " << line << endl;
+            return false;
         }
 
-        csvFile.close();
-        cout << "Parsing table saved to " << filename << endl;
+        cout << "\nEdit: " << line << endl;
+        GrammarEdit edit;
+        int applied = 0;
+        if (command == "add") applied = cfg.addProduction(lhs, rhs, edit);
+        else if (command == "remove") applied = cfg.removeProduction(lhs, rhs, edit);
+        else if (command == "replace") applied = cfg.replaceProduction(lhs, rhs.substr(0, replacement), rhs.substr(replacement + 2), edit);
+        else cerr << "Error: Unknown edit command " << command << endl;
+        if (applied) printGrammarEdit(cout, edit);
     }
+    return true;
+}
 
-};
-
-int main() {
+int main(int argc, char* argv[]) {
     string fileName = "cfg.txt";
+    bool solverStats = false;
+    bool reduce = true;
+    bool inlining = false;
+    string stepsInput = "input_strings.txt";
+    uint32_t tableFlags = 0;
+    string directParserFile;
+    string editsFile;
+    string cacheDir = ".zeta-cache";
+    bool useCache = true;
+    bool asyncLog = false;
+    string jsonlFile, exportFile;
     Grammar cfg;
 
+    // usage: Parser [--solver-stats] [--no-reduce] [--inline] [--steps-input=FILE] [--compress-table]
+    //               [--default-productions] [--expansion-chains] [--emit-cpp=FILE] [--cache-dir=DIR]
+    //               [--no-cache] [--edits=FILE] [--async-log] [--export-jsonl=FILE] [--export-binary=FILE]
+    //               [grammar-file]
+    //   --no-reduce            keep non-productive, unreachable and duplicate non-terminals
+    //   --inline               inline single-alternative non-terminals and collapse unit chains, then
+    //                          compare expand steps per token on --steps-input (input_strings.txt)
+    //   --compress-table       write the action table with row displacement and merged rows
+    //   --default-productions  as --compress-table, and empty cells take the row's most common production
+    //   --expansion-chains     cells starting several expansions in a row name one precomputed chain
+    //   --cache-dir=DIR        where analysis results are kept between runs (.zeta-cache, last 64 used)
+    //   --no-cache             always run the analysis; --solver-stats implies it
+    //   --edits=FILE           then add, remove or replace productions incrementally (see applyEdits)
+    //   --async-log            write output.log from a background thread
+    //   --export-jsonl=FILE    grammar, FIRST/FOLLOW, table and conflicts as JSON lines (see GrammarExport.h)
+    //   --export-binary=FILE   the same in a compact binary form
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--solver-stats") solverStats = true;
+        else if (arg == "--no-reduce") reduce = false;
+        else if (arg == "--inline") inlining = true;
+        else if (arg.rfind("--steps-input=", 0) == 0) stepsInput = arg.substr(14);
+        else if (arg == "--compress-table") tableFlags |= ZLL1_FLAG_COMPRESSED_ACTIONS;
+        else if (arg == "--default-productions") tableFlags |= ZLL1_FLAG_COMPRESSED_ACTIONS | ZLL1_FLAG_DEFAULT_PRODUCTIONS;
+        else if (arg == "--expansion-chains") tableFlags |= ZLL1_FLAG_EXPANSION_CHAINS;
+        else if (arg.rfind("--emit-cpp=", 0) == 0) directParserFile = arg.substr(11);
+        else if (arg.rfind("--cache-dir=", 0) == 0) cacheDir = arg.substr(12);
+        else if (arg == "--no-cache") useCache = false;
+        else if (arg.rfind("--edits=", 0) == 0) editsFile = arg.substr(8);
+        else if (arg == "--async-log") asyncLog = true;
+        else if (arg.rfind("--export-jsonl=", 0) == 0) jsonlFile = arg.substr(15);
+        else if (arg.rfind("--export-binary=", 0) == 0) exportFile = arg.substr(16);
+        else fileName = arg;
+    }
+
     // Redirect cout and cerr to both console and file
     ofstream outFile("output.log");
+    streambuf* logBuf = outFile.rdbuf();
+    unique_ptr<AsyncLogWriter> logWriter;
+    if (asyncLog) {
+        logWriter = make_unique<AsyncLogWriter>(outFile.rdbuf());
+        logBuf = logWriter.get();
+    }
 
     // TeeBuf to duplicate cout output to both the console and the file
-    TeeBuf coutTeeBuf(cout.rdbuf(), outFile.rdbuf());
+    TeeBuf coutTeeBuf(cout.rdbuf(), logBuf);
 
     // TeeBuf to duplicate cerr output to both the console and the file
-    TeeBuf cerrTeeBuf(cerr.rdbuf(), outFile.rdbuf());
+    // (cerr is tied to cout, so cout's buffered text always reaches the file first)
+    TeeBuf cerrTeeBuf(cerr.rdbuf(), logBuf);
 
     // redirect cout to use the custom TeeBuf, saving the original buffer
     streambuf* originalCout = cout.rdbuf(&coutTeeBuf);
@@ -878,43 +273,140 @@ int main() {
     // redirect cerr to use the custom TeeBuf, saving the original buffer
     streambuf* originalCerr = cerr.rdbuf(&cerrTeeBuf);
 
-    if (cfg.readGrammar(fileName)) {
-        cout << "Original Grammar:" << endl;
-        cfg.printGrammar();
-
-        // left factoring
-        cfg.leftFactoring();
-        cout << "\nGrammar after left factoring:" << endl;
-        cfg.printGrammar();
-
-
-        // left recursion elimination
-        cfg.leftRecursion();
-        cout << "\nGrammar after left recursion elimination:" << endl;
-        cfg.printGrammar();
-
-
-        // Compute First and Follow sets
-        cfg.computeFirst();
-        cfg.computeFollow();
-        cout << "\nGrammar after computing first follow:" << endl;
-        cfg.printFirstAndFollow();
-
-
-        // Compute LL(1) Parsing Table
-        cfg.computeParsingTable();
-        cout << "\nGrammar after computing parsing table:" << endl;
-        cfg.printParsingTable();
+    // a table that does not fit in memory ends the run with its size rather than an abort
+    int status = EXIT_SUCCESS;
+    try {
+        if (cfg.readGrammar(fileName)) {
+            cout << "Original Grammar:" << endl;
+            cfg.printGrammar();
+
+            // the solver comparison needs the solvers to run, so it never uses the cache
+            AnalysisCache cache(cacheDir);
+            useCache = useCache && !solverStats;
+            if (useCache) cache.open(cfg.ir, string("reduce=") + (reduce ? "1" : "0") + " inline=" + (inlining ? "1" : "0"));
+            // what the passes print is kept with the cache entry and replayed on a hit, so the log
+            // reads the same whether or not the analysis was cached
+            string transformReport;
+            bool cached = useCache && cache.load(cfg, transformReport);
+
+            PassManager passes;
+            GrammarReduction reduction;
+            InliningReport inlined;
+            Grammar beforeInlining;
+            auto report = [&](const function<void(ostream&)>& print) {
+                ostringstream out;
+                print(out);
+                cout << out.str();
+                transformReport += out.str();
+            };
+            if (cached) {
+                cout << "\nAnalysis restored from " << cache.path() << endl;
+                cout << transformReport;
+            } else {
+                // left factoring, left recursion elimination and reduction, then drop the arena words they left behind
+                passes.add("left factoring", factorLeft);
+                passes.add("left recursion elimination", eliminateLeftRecursion);
+                if (reduce) passes.add("reduction", [&](GrammarIR& ir) { return reduceGrammar(ir, reduction); });
+                if (inlining) {
+                    passes.add("inlining", [&](GrammarIR&) {
+                        beforeInlining = cfg;
+                        return cfg.inlineRules(inlined);
+                    });
+                }
+                passes.add("compact", [](GrammarIR& ir) { ir.compact(); return 1; });
+                passes.run(cfg.ir, [&](const string& pass) {
+                    if (pass == "compact") return;
+                    report([&](ostream& out) {
+                        out << "\nGrammar after " << pass << ":" << endl;
+                        cfg.printGrammar(out);
+                        if (pass == "reduction") printReduction(out, reduction);
+                        if (pass == "inlining") printInlining(out, inlined);
+                    });
+                });
+                report([&](ostream& out) {
+                    out << "\nTransformation passes:" << endl;
+                    passes.printReport(out);
+                });
+
+
+                // Compute First and Follow sets
+                cfg.computeFirst();
+                cfg.computeFollow();
+            }
+            cout << "\nGrammar after computing first follow:" << endl;
+            cfg.printFirstAndFollow();
+
+            if (solverStats) {
+                // rerun the analysis with whole-grammar sweeps on a copy and compare
+                Grammar sweep = cfg;
+                sweep.computeFirstBySweep();
+                sweep.computeFollowBySweep();
+                cout << endl;
+                printSolverComparison("FIRST", cfg.firstStats, sweep.firstStats);
+                printSolverComparison("FOLLOW", cfg.followStats, sweep.followStats);
+            }
 
-        cfg.writeParsingTableToCSV("ll1_parsing_table.csv");
 
+            // Compute LL(1) Parsing Table; grammars with conflicts are not cached, so their reports show on every run
+            if (!cached) {
+                cfg.computeParsingTable();
+                if (useCache && cfg.conflicts.empty()) cache.store(cfg, transformReport);
+            }
+            if (!editsFile.empty() && applyEdits(cfg, editsFile)) {
+                cout << "\nGrammar after edits:" << endl;
+                cfg.printGrammar();
+                cfg.printFirstAndFollow();
+            }
+            cout << "\nGrammar after computing parsing table:" << endl;
+            cfg.printParsingTable();
+
+            cfg.writeParsingTableToCSV("ll1_parsing_table.csv");
+            cfg.writeParsingTableToBinary("ll1_parsing_table.bin", tableFlags);
+            if (!directParserFile.empty()) cfg.writeDirectParser(directParserFile);
+            if (!jsonlFile.empty()) exportAnalysis(cfg, jsonlFile, false);
+            if (!exportFile.empty()) exportAnalysis(cfg, exportFile, true);
+
+            if (inlining && cached) {
+                cout << "\nExpand steps per token not measured: the grammar before inlining is not cached (use --no-cache)" << endl;
+            } else if (inlining) {
+                // same input through the table before and after inlining; the baseline's own
+                // conflict reports were already printed once, so they are not repeated
+                streambuf* log = cerr.rdbuf(nullptr);
+                beforeInlining.computeFirst();
+                beforeInlining.computeFollow();
+                beforeInlining.computeParsingTable();
+                cerr.rdbuf(log);
+
+                trace_level = TRACE_LEVEL_SILENT;
+                ParseTotals before, after;
+                if (countParseSteps(beforeInlining.parsingTableImage(), stepsInput, before) &&
+                    countParseSteps(cfg.parsingTableImage(), stepsInput, after)) {
+                    cout << "\nExpand steps per token on " << stepsInput << " (" << before.tokens << " tokens): "
+                         << fixed << setprecision(3) << expandStepsPerToken(before) << " before inlining, "
+                         << expandStepsPerToken(after) << " after" << defaultfloat << setprecision(6) << endl;
+                    if (before.accepted != after.accepted) {
+                        cerr << "Warning: " << before.accepted << " lines accepted before inlining, " << after.accepted << " after" << endl;
+                    }
+                } else {
+                    cout << "\nNo input to measure expand steps: could not open " << stepsInput << endl;
+                }
+            }
         }
+    } catch (const bad_alloc&) {
+        cerr << "Error: out of memory with a parsing table of " << cfg.nonTerminals.size() << " non-terminals x "
+             << cfg.terminals.size() << " terminals (" << cfg.tableCellCount() << " non-empty cells)"
+             << ((tableFlags & ZLL1_FLAG_COMPRESSED_ACTIONS) ? "" : "; --compress-table stores only the non-empty cells") << endl;
+        status = EXIT_FAILURE;
+    }
 
     // restore original buffers and close file
+    cout.flush();
+    cerr.flush();
     cout.rdbuf(originalCout);
     cerr.rdbuf(originalCerr);
+    if (logWriter) logWriter->finish();
     outFile.close();
 
-    return 0;
+    return status;
 }
 
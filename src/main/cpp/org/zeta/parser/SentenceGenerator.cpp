@@ -0,0 +1,263 @@
+//
+// Generates token corpora for Stack from the compiled parsing table written by Parser.
+//
+// Every line is one sentence derived from the start symbol by picking random productions.
+// Derivations are kept finite with the minimum height of every production: below the depth
+// limit, or once the line has reached its token budget, only productions that can still
+// finish in time (or the shortest ones) are chosen. With --invalid, that share of the lines
+// is mutated (token dropped, inserted, replaced or swapped) until the table rejects it.
+//
+// usage: SentenceGenerator [--table=ll1_parsing_table.bin] [--tokens=1000000] [--max-depth=32]
+//                          [--line-tokens=64] [--invalid=0] [--seed=1] [--output=input_strings.txt | -]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include "ParseTableFormat.h"
+
+#define UNREACHABLE_HEIGHT 0x3fffffff
+#define MUTATION_ATTEMPTS 16
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+// Compiled table read into memory
+typedef struct {
+    std::vector<char> data;
+    const ZLL1Header *header;
+    int end_marker;
+    std::vector<std::vector<int>> productions_of;   // production indices by non-terminal row
+    std::vector<int> production_height;             // minimum derivation height of each production
+    std::vector<int> symbol_height;                 // minimum derivation height of each symbol (0 for terminals)
+} Table;
+
+void load_table(Table *t, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("Error opening parsing table");
+        exit(EXIT_FAILURE);
+    }
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) t->data.insert(t->data.end(), chunk, chunk + n);
+    fclose(file);
+
+    const char *error = NULL;
+    if (!zll1_validate(t->data.data(), t->data.size(), &error)) {
+        fprintf(stderr, "Error: %s: %s\n", filename, error);
+        exit(EXIT_FAILURE);
+    }
+    t->header = (const ZLL1Header *)t->data.data();
+    t->end_marker = zll1_find_symbol(t->header, "$", 1);
+}
+
+// Group productions by LHS and compute minimum heights (fixed point over the productions)
+void analyze_table(Table *t) {
+    const ZLL1Header *h = t->header;
+    const ZLL1Production *productions = zll1_productions(h);
+    const int32_t *rhs = zll1_rhs(h);
+    int terminals = (int)h->num_terminals;
+
+    t->productions_of.assign(h->num_symbols - h->num_terminals, {});
+    for (uint32_t p = 0; p < h->num_productions; p++) {
+        t->productions_of[productions[p].lhs - terminals].push_back((int)p);
+    }
+
+    t->symbol_height.assign(h->num_symbols, UNREACHABLE_HEIGHT);
+    for (int id = 0; id < terminals; id++) t->symbol_height[id] = 0;
+    t->production_height.assign(h->num_productions, UNREACHABLE_HEIGHT);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (uint32_t p = 0; p < h->num_productions; p++) {
+            int height = 0;
+            for (uint32_t i = 0; i < productions[p].rhs_length; i++) {
+                int symbol_height = t->symbol_height[rhs[productions[p].rhs_offset + i]];
+                if (symbol_height > height) height = symbol_height;
+            }
+            if (height == UNREACHABLE_HEIGHT) continue;
+            t->production_height[p] = height + 1;
+            if (height + 1 < t->symbol_height[productions[p].lhs]) {
+                t->symbol_height[productions[p].lhs] = height + 1;
+                changed = true;
+            }
+        }
+    }
+    if (t->symbol_height[h->start_symbol] == UNREACHABLE_HEIGHT) {
+        fprintf(stderr, "Error: the start symbol derives no finite sentence\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+const char* symbol_name(const Table *t, int id) {
+    return zll1_strings(t->header) + zll1_symbols(t->header)[id].name_offset;
+}
+
+// Derive one sentence (terminal IDs) from the start symbol
+void derive_sentence(const Table *t, std::mt19937 &rng, int max_depth, size_t line_tokens, std::vector<int> &sentence) {
+    const ZLL1Header *h = t->header;
+    const ZLL1Production *productions = zll1_productions(h);
+    const int32_t *rhs = zll1_rhs(h);
+    int terminals = (int)h->num_terminals;
+
+    // (symbol, depth) pairs, the next one to expand on top
+    std::vector<std::pair<int, int>> stack = {{h->start_symbol, 0}};
+    std::vector<int> candidates;
+    sentence.clear();
+    while (!stack.empty()) {
+        auto [symbol, depth] = stack.back();
+        stack.pop_back();
+        if (symbol < terminals) {
+            sentence.push_back(symbol);
+            continue;
+        }
+
+        // productions that still fit below the depth limit, or else the shortest ones
+        const std::vector<int> &options = t->productions_of[symbol - terminals];
+        int budget = sentence.size() >= line_tokens ? 0 : max_depth - depth;
+        int lowest = UNREACHABLE_HEIGHT;
+        for (int p : options) if (t->production_height[p] < lowest) lowest = t->production_height[p];
+        candidates.clear();
+        for (int p : options) {
+            if (t->production_height[p] <= budget || t->production_height[p] == lowest) candidates.push_back(p);
+        }
+        int p = candidates[std::uniform_int_distribution<size_t>(0, candidates.size() - 1)(rng)];
+
+        // the RHS is stored reversed, i.e. already in stack order
+        for (uint32_t i = 0; i < productions[p].rhs_length; i++) {
+            stack.push_back({rhs[productions[p].rhs_offset + i], depth + 1});
+        }
+    }
+}
+
+// Run the table on a sentence, as Stack would
+bool accepts(const Table *t, const std::vector<int> &sentence) {
+    const ZLL1Header *h = t->header;
+    const ZLL1Production *productions = zll1_productions(h);
+    const int32_t *rhs = zll1_rhs(h);
+    int terminals = (int)h->num_terminals;
+
+    std::vector<int> stack = {t->end_marker, h->start_symbol};
+    size_t next = 0;
+    for (;;) {
+        int token = next < sentence.size() ? sentence[next] : t->end_marker;
+        int top = stack.back();
+        if (top == token) {
+            if (top == t->end_marker) return next == sentence.size();
+            stack.pop_back();
+            next++;
+            continue;
+        }
+        if (top < terminals) return false;
+        int p = zll1_lookup(h, top - terminals, token);
+        if (p == ZLL1_NO_PRODUCTION) return false;
+        stack.pop_back();
+        stack.insert(stack.end(), rhs + productions[p].rhs_offset, rhs + productions[p].rhs_offset + productions[p].rhs_length);
+    }
+}
+
+// Turn a valid sentence into a near miss: one small edit the table rejects.
+// Returns false if no attempt produced an invalid sentence.
+bool mutate_sentence(const Table *t, std::mt19937 &rng, std::vector<int> &sentence) {
+    // any terminal except $ can be inserted
+    auto random_terminal = [&]() {
+        int id;
+        do id = std::uniform_int_distribution<int>(0, (int)t->header->num_terminals - 1)(rng);
+        while (id == t->end_marker);
+        return id;
+    };
+    std::vector<int> original = sentence;
+    for (int attempt = 0; attempt < MUTATION_ATTEMPTS; attempt++) {
+        sentence = original;
+        size_t n = sentence.size();
+        int kind = std::uniform_int_distribution<int>(0, 3)(rng);
+        if (n == 0) kind = 1;
+        size_t at = n ? std::uniform_int_distribution<size_t>(0, n - 1)(rng) : 0;
+        switch (kind) {
+            case 0: sentence.erase(sentence.begin() + at); break;                       // drop
+            case 1: sentence.insert(sentence.begin() + at, random_terminal()); break;   // insert
+            case 2: sentence[at] = random_terminal(); break;                             // replace
+            case 3:                                                                       // swap
+                if (at + 1 < n) std::swap(sentence[at], sentence[at + 1]);
+                break;
+        }
+        if (!sentence.empty() && !accepts(t, sentence)) return true;
+    }
+    sentence = original;
+    return false;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "usage: %s [--table=ll1_parsing_table.bin] [--tokens=1000000] [--max-depth=32] [--line-tokens=64]"
+                    " [--invalid=0] [--seed=1] [--output=input_strings.txt | -]\n", program);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    const char *table_path = "ll1_parsing_table.bin";
+    const char *output_path = "input_strings.txt";
+    unsigned long long target_tokens = 1000000;
+    int max_depth = 32;
+    size_t line_tokens = 64;
+    double invalid = 0.0;
+    unsigned long seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        char *end = NULL;
+        if (strncmp(arg, "--table=", 8) == 0) table_path = arg + 8;
+        else if (strncmp(arg, "--output=", 9) == 0) output_path = arg + 9;
+        else if (strncmp(arg, "--tokens=", 9) == 0) target_tokens = strtoull(arg + 9, &end, 10);
+        else if (strncmp(arg, "--max-depth=", 12) == 0) max_depth = (int)strtol(arg + 12, &end, 10);
+        else if (strncmp(arg, "--line-tokens=", 14) == 0) line_tokens = (size_t)strtoull(arg + 14, &end, 10);
+        else if (strncmp(arg, "--invalid=", 10) == 0) invalid = strtod(arg + 10, &end);
+        else if (strncmp(arg, "--seed=", 7) == 0) seed = strtoul(arg + 7, &end, 10);
+        else usage(argv[0]);
+        if (end && *end != '\0') usage(argv[0]);
+    }
+    if (max_depth < 1 || invalid < 0 || invalid > 1) usage(argv[0]);
+
+    Table table;
+    load_table(&table, table_path);
+    analyze_table(&table);
+
+    FILE *out = strcmp(output_path, "-") == 0 ? stdout : fopen(output_path, "w");
+    if (!out) {
+        perror("Error creating output file");
+        return EXIT_FAILURE;
+    }
+    setvbuf(out, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    std::mt19937 rng((std::mt19937::result_type)seed);
+    std::bernoulli_distribution make_invalid(invalid);
+    std::vector<int> sentence;
+    unsigned long long tokens = 0, lines = 0, invalid_lines = 0, empty_lines = 0, bytes = 0;
+    while (tokens < target_tokens) {
+        derive_sentence(&table, rng, max_depth, line_tokens, sentence);
+        if (sentence.empty()) {
+            // Stack skips empty lines, so an empty sentence cannot be written; it is re-derived
+            // before the near-miss draw, which would otherwise turn it into a one-token insertion
+            // and push the invalid share above the requested rate
+            if (++empty_lines > 1000 && lines == 0) {
+                fprintf(stderr, "Error: the start symbol only derives the empty sentence\n");
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+        if (invalid > 0 && make_invalid(rng) && mutate_sentence(&table, rng, sentence)) invalid_lines++;
+        for (size_t i = 0; i < sentence.size(); i++) {
+            const char *name = symbol_name(&table, sentence[i]);
+            if (i) fputc(' ', out);
+            fputs(name, out);
+            bytes += strlen(name) + 1;
+        }
+        fputc('\n', out);
+        tokens += sentence.size();
+        lines++;
+    }
+
+    if (out != stdout) fclose(out);
+    else fflush(out);
+    fprintf(stderr, "Generated %llu lines, %llu tokens (%llu bytes), %llu near-miss invalid lines\n",
+            lines, tokens, bytes, invalid_lines);
+    return EXIT_SUCCESS;
+}
@@ -4,307 +4,145 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdbool.h>
-#include <vector>
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <fstream>
-
-#define MAX_STACK_SIZE 100
-#define MAX_INPUT_LEN 1000
-#define MAX_PROD_LEN 100
-#define MAX_SYMBOL_LEN 20
-#define MAX_TABLE_ENTRIES 100
-
-// Data structure for parsing table entries
-typedef struct {
-    char non_terminal[MAX_SYMBOL_LEN];
-    char terminal[MAX_SYMBOL_LEN];
-    char production[MAX_PROD_LEN];
-} ParsingTableEntry;
-
-ParsingTableEntry parsing_table[MAX_TABLE_ENTRIES];
-int table_size = 0;
-std::vector<std::string> terminals; // Store terminals from header
-
-// Stack structure
-typedef struct {
-    char items[MAX_STACK_SIZE][MAX_SYMBOL_LEN];
-    int top;
-} Stack;
-
-// Initialize stack with start symbol and $
-void stack_init(Stack *s, const char *start_symbol) {
-    s->top = -1;
-    strcpy(s->items[++s->top], "$");
-    strcpy(s->items[++s->top], start_symbol);
+#include <time.h>
+#include <unistd.h>
+#include <thread>
+#include "ParseDriver.h"
+#include "ZetaParser.h"
+
+// cfg.txt compiled into the binary, when the build generated it (ZETA_BUILTIN_GRAMMAR)
+#if __has_include("BuiltinGrammar.h")
+#include "BuiltinGrammar.h"
+#include "ConstexprGrammar.h"
+#define HAVE_BUILTIN_GRAMMAR 1
+typedef zeta::ConstexprGrammar<zeta::FixedString(builtin_grammar)> BuiltinGrammar;
+#endif
+
+static double elapsed_seconds(const struct timespec &since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - since.tv_sec) + (double)(now.tv_nsec - since.tv_nsec) / 1e9;
 }
 
-// Push a symbol onto the stack
-void stack_push(Stack *s, const char *symbol) {
-    if (s->top >= MAX_STACK_SIZE - 1) {
-        fprintf(stderr, "Stack overflow!\n");
-        exit(EXIT_FAILURE);
-    }
-    strcpy(s->items[++s->top], symbol);
+static void usage(const char *program) {
+    fprintf(stderr, "usage: %s [--trace=silent|summary|steps|verbose] [--trace-file=PATH] [--jobs=N] [--builtin | --grammar=FILE] [input-file | -]\n", program);
+    exit(EXIT_FAILURE);
 }
 
-// Pop a symbol from the stack
-char* stack_pop(Stack *s) {
-    if (s->top < 0) {
-        fprintf(stderr, "Stack underflow!\n");
-        exit(EXIT_FAILURE);
-    }
-    return s->items[s->top--];
-}
-
-// Peek at the top of the stack
-char* stack_peek(Stack *s) {
-    return (s->top >= 0) ? s->items[s->top] : NULL;
-}
-
-// Load parsing table from a CSV file
-void load_parsing_table(const char *filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        perror("Error opening parsing table file");
-        exit(EXIT_FAILURE);
-    }
-
-    std::string line;
-    bool header_read = false;
-
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string segment;
-        std::vector<std::string> segments;
-
-        while (std::getline(ss, segment, ',')) {
-            // Trim leading/trailing whitespace if necessary (basic trim)
-            segment.erase(0, segment.find_first_not_of(" \t\n\r\f\v"));
-            segment.erase(segment.find_last_not_of(" \t\n\r\f\v") + 1);
-            segments.push_back(segment);
-        }
-
-        if (segments.empty()) continue; // Skip empty lines
-
-        if (!header_read) {
-            // Read header: first segment is "Non-Terminal", skip it
-            for (size_t i = 1; i < segments.size(); ++i) {
-                terminals.push_back(segments[i]);
-            }
-            header_read = true;
+// usage: Stack [--trace=LEVEL] [--trace-file=PATH] [--jobs=N] [--builtin | --grammar=FILE] [input-file | -]   ("-" streams tokens from stdin)
+//   silent   no per-line output
+//   summary  one line per parse and the totals (default)
+//   steps    as summary, and binary step records of every failed parse are written to the
+//            trace file (parse_trace.bin), followed by the most recent records at exit;
+//            TraceDump prints them
+//   verbose  the full stack, input and action at every step
+// --jobs=N parses a file with N threads (0: one per core); output stays in input order.
+// --builtin uses the table of cfg.txt built at compile time instead of Parser's table files.
+// --grammar=FILE compiles the table of a cfg.txt-format grammar in-process (ZetaParser.h),
+//   with Parser's default transformations, instead of reading Parser's table files.
+// Exits with status 1 if any line was rejected.
+int main(int argc, char *argv[]) {
+    const char *input_path = "input_strings.txt";
+    int jobs = 1;
+    bool builtin = false;
+    const char *grammar_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--trace=", 8) == 0) {
+            const char *level = arg + 8;
+            if (strcmp(level, "silent") == 0) trace_level = TRACE_LEVEL_SILENT;
+            else if (strcmp(level, "summary") == 0) trace_level = TRACE_LEVEL_SUMMARY;
+            else if (strcmp(level, "steps") == 0) trace_level = TRACE_LEVEL_STEPS;
+            else if (strcmp(level, "verbose") == 0) trace_level = TRACE_LEVEL_VERBOSE;
+            else usage(argv[0]);
+        } else if (strncmp(arg, "--trace-file=", 13) == 0) {
+            trace_path = arg + 13;
+        } else if (strncmp(arg, "--jobs=", 7) == 0) {
+            char *end;
+            long n = strtol(arg + 7, &end, 10);
+            if (*end != '\0' || n < 0 || n > 1024) usage(argv[0]);
+            jobs = n == 0 ? (int)std::thread::hardware_concurrency() : (int)n;
+            if (jobs < 1) jobs = 1;
+        } else if (strcmp(arg, "--builtin") == 0) {
+            builtin = true;
+        } else if (strncmp(arg, "--grammar=", 10) == 0) {
+            grammar_path = arg + 10;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            usage(argv[0]);
         } else {
-            // Read data row
-            if (segments.size() < 1) continue; // Malformed row
-            std::string non_terminal = segments[0];
-
-            for (size_t i = 1; i < segments.size(); ++i) {
-                if (i - 1 < terminals.size() && !segments[i].empty()) {
-                    if (table_size >= MAX_TABLE_ENTRIES) {
-                        fprintf(stderr, "Parsing table size exceeded MAX_TABLE_ENTRIES\n");
-                        exit(EXIT_FAILURE);
-                    }
-
-                    std::string production_full = segments[i]; // e.g., " E → T E'"
-                    std::string production_rhs;
-
-                    // Find the arrow '→' or '->'
-                    size_t arrow_pos = production_full.find("→");
-                    std::string arrow_str = "→";
-                    size_t arrow_len = std::string(arrow_str).length(); // Get length of arrow string
-
-                    if (arrow_pos == std::string::npos) {
-                         arrow_pos = production_full.find("->");
-                         arrow_str = "->";
-                         arrow_len = std::string(arrow_str).length(); // Get length of arrow string
-                    }
-
-                    if (arrow_pos != std::string::npos) {
-                        // Extract substring AFTER the arrow
-                        if (arrow_pos + arrow_len < production_full.length()) {
-                            production_rhs = production_full.substr(arrow_pos + arrow_len);
-                        } else {
-                            // Arrow is at the very end, means epsilon
-                            production_rhs = "ε";
-                        }
-                    } else if (production_full == "ε") {
-                        production_rhs = "ε"; // Handle epsilon explicitly if no arrow
-                    } else {
-                         // No arrow found, and not epsilon. Assume the segment IS the RHS.
-                         production_rhs = production_full;
-                         // Optional: Add warning if format strictly requires an arrow
-                         // fprintf(stderr, "Warning: No arrow found in production '%s'. Assuming it's the RHS.\n", production_full.c_str());
-                    }
-
-                    // Trim leading/trailing whitespace from the extracted RHS
-                    production_rhs.erase(0, production_rhs.find_first_not_of(" \t\n\r\f\v"));
-                    production_rhs.erase(production_rhs.find_last_not_of(" \t\n\r\f\v") + 1);
-
-                    // Ensure RHS is not empty after trimming, default to epsilon if it is
-                    // (unless the original segment was already epsilon)
-                    if (production_rhs.empty() && production_full != "ε") {
-                         production_rhs = "ε";
-                    }
-
-                    // Store the cleaned RHS
-                    if (production_rhs.length() >= MAX_PROD_LEN) {
-                         fprintf(stderr, "Error: Production RHS '%s' too long (max %d)\n", production_rhs.c_str(), MAX_PROD_LEN - 1);
-                         exit(EXIT_FAILURE);
-                    }
-                    if (strlen(non_terminal.c_str()) >= MAX_SYMBOL_LEN) {
-                         fprintf(stderr, "Error: Non-terminal '%s' too long (max %d)\n", non_terminal.c_str(), MAX_SYMBOL_LEN - 1);
-                         exit(EXIT_FAILURE);
-                    }
-                     if (terminals[i - 1].length() >= MAX_SYMBOL_LEN) {
-                         fprintf(stderr, "Error: Terminal '%s' too long (max %d)\n", terminals[i - 1].c_str(), MAX_SYMBOL_LEN - 1);
-                         exit(EXIT_FAILURE);
-                    }
-
-                    strcpy(parsing_table[table_size].non_terminal, non_terminal.c_str());
-                    strcpy(parsing_table[table_size].terminal, terminals[i - 1].c_str());
-                    strcpy(parsing_table[table_size].production, production_rhs.c_str());
-                    table_size++;
-                }
-            }
+            input_path = arg;
         }
     }
 
-    if (!header_read) {
-         fprintf(stderr, "Error: Could not read header from parsing table file.\n");
-         exit(EXIT_FAILURE);
-    }
-    if (table_size == 0) {
-        fprintf(stderr, "Warning: No entries loaded from parsing table.\n");
+    // Use the tables generated by Parser.cpp: the compiled one if present, else the CSV export
+    ParsingTable table = {};
+    ZetaTable *compiled = NULL;
+    if (builtin) {
+#ifdef HAVE_BUILTIN_GRAMMAR
+        load_parsing_table_image(&table, BuiltinGrammar::header(), BuiltinGrammar::size());
+#else
+        fprintf(stderr, "Error: this build has no built-in grammar (configure with ZETA_BUILTIN_GRAMMAR=ON).\n");
+        return EXIT_FAILURE;
+#endif
+    } else if (grammar_path) {
+        ZetaGrammar *grammar = zeta_grammar_load(grammar_path);
+        if (grammar && zeta_grammar_transform(grammar, ZETA_DEFAULT_TRANSFORMS) == 0) compiled = zeta_table_compile(grammar, 0);
+        if (grammar) fputs(zeta_grammar_messages(grammar), stderr);
+        zeta_grammar_free(grammar);
+        if (!compiled) {
+            fprintf(stderr, "Error: %s\n", zeta_last_error());
+            return EXIT_FAILURE;
+        }
+        size_t size;
+        const void *image = zeta_table_image(compiled, &size);
+        load_parsing_table_image(&table, image, size);
+    } else if (!load_parsing_table_binary(&table, "ll1_parsing_table.bin")) {
+        load_parsing_table(&table, "ll1_parsing_table.csv");
     }
-}
 
-// Get production for a non-terminal and terminal
-const char* get_production(const char *nt, const char *term) {
-    for (int i = 0; i < table_size; i++) {
-        if (strcmp(parsing_table[i].non_terminal, nt) == 0 &&
-            strcmp(parsing_table[i].terminal, term) == 0) {
-            return parsing_table[i].production;
+    TokenReader reader;
+    if (strcmp(input_path, "-") == 0) {
+        reader_open_stream(&reader, STDIN_FILENO);
+        if (jobs > 1) {
+            fprintf(stderr, "Warning: --jobs needs an input file; parsing stdin on one thread.\n");
+            jobs = 1;
         }
+    } else if (!reader_open_file(&reader, input_path)) {
+        perror("Error opening input file");
+        return EXIT_FAILURE;
     }
-    return NULL; // No entry found (error)
-}
-
-// Parse a single input string
-void parse_input(const char *input, const char *start_symbol) {
-    Stack s;
-    stack_init(&s, start_symbol);
-    char input_copy[MAX_INPUT_LEN];
-    strcpy(input_copy, input);
-    char *token = strtok(input_copy, " "); // Initial tokenization
-    int step = 1;
-    bool error = false;
 
-    printf("\nParsing: %s\n", input);
-    printf("-------------------------------\n");
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
 
-    while (stack_peek(&s) != NULL) {
-        // Print current stack and input
-        printf("Step %d:\n", step++);
-        printf("Stack: ");
-        for (int i = s.top; i >= 0; i--) {
-            printf("%s ", s.items[i]);
+    ParseTotals totals = {0, 0, 0, 0};
+    if (jobs > 1) {
+        parse_batch(&table, &reader, jobs, &totals);
+    } else {
+        // One parse per non-empty line
+        ParseWorker worker;
+        worker_init(&worker);
+        while (reader_next_line(&reader)) {
+            parse_input(&table, &worker, &reader);
         }
-        // Determine current input symbol (use $ if token is NULL)
-        const char *current_input = token ? token : "$";
-        printf("\nInput: %s\n", current_input);
-
-        char *top = stack_peek(&s);
-
-        // Check for terminal match or end of input
-        if (strcmp(top, current_input) == 0) {
-            if (strcmp(top, "$") == 0) { // Both stack top and input are $
-                printf("Action: Accept\n");
-                break; // Successful parse
-            } else { // Matched a terminal
-                printf("Action: Match '%s'\n", token);
-                stack_pop(&s);
-                token = strtok(NULL, " "); // Get next token
-            }
-        } else { // Top is a non-terminal, need to expand
-            const char *prod = get_production(top, current_input);
-            if (!prod) {
-                printf("Error: No production for %s on input '%s'\n", top, current_input);
-                error = true;
-                break;
-            }
-            printf("Action: Expand %s -> %s\n", top, prod);
-            stack_pop(&s);
-
-            if (strcmp(prod, "ε") != 0) { // Don't push anything for epsilon
-                std::string prod_str(prod);
-                std::stringstream prod_ss(prod_str);
-                std::string prod_part_str;
-                std::vector<std::string> parts; // Use vector to store parts
-
-                // Split the production RHS using stringstream
-                while (prod_ss >> prod_part_str) {
-                    parts.push_back(prod_part_str);
-                }
-
-                // Push parts onto stack in reverse order
-                for (int i = parts.size() - 1; i >= 0; i--) {
-                    if (parts[i].length() >= MAX_SYMBOL_LEN) {
-                        fprintf(stderr, "Error: Symbol '%s' in production '%s' too long (max %d)\n", parts[i].c_str(), prod, MAX_SYMBOL_LEN - 1);
-                        error = true;
-                        break; // Break inner loop
-                    }
-                    stack_push(&s, parts[i].c_str());
-                }
-                if (error) break; // Break outer loop if symbol was too long
-            }
+        if (trace_level == TRACE_LEVEL_STEPS) {
+            // the most recent records not written yet (at most one ring's worth)
+            trace_dump(&table, &worker, worker.trace_dumped);
         }
-        printf("\n"); // Add newline for better formatting
+        totals = worker.totals;
+        worker_free(&worker);
     }
 
-    // Final check after loop
-    if (!error && token != NULL && strcmp(stack_peek(&s), "$") == 0) {
-        // If stack is accepted ($) but there's still input left
-        printf("Error: Stack accepted but input remaining: %s\n", token);
-        error = true;
-    } else if (!error && strcmp(stack_peek(&s), "$") != 0) {
-        // If input is exhausted (token is NULL) but stack isn't $
-        printf("Error: Input exhausted but stack not empty. Top: %s\n", stack_peek(&s));
-        error = true;
+    if (trace_level == TRACE_LEVEL_SUMMARY || trace_level == TRACE_LEVEL_STEPS) {
+        double seconds = elapsed_seconds(started);
+        printf("Parsed %zu lines: %zu accepted, %zu rejected, %zu tokens, %zu steps in %.3f s (%.0f tokens/s)\n",
+               totals.lines, totals.accepted, totals.lines - totals.accepted, totals.tokens, totals.steps,
+               seconds, seconds > 0 ? (double)totals.tokens / seconds : 0.0);
     }
+    if (trace_file) fclose(trace_file);
 
-    if (error) {
-        printf("\nParsing failed with errors.\n");
-    } else if (strcmp(stack_peek(&s), "$") == 0 && token == NULL) {
-        // Ensure we accepted correctly (stack is $, input is consumed)
-        printf("\nParsing succeeded.\n");
-    } else {
-        // Catch unexpected end states
-        printf("\nParsing finished in an unexpected state.\n");
-        if (token != NULL) printf("Remaining input: %s\n", token);
-        printf("Final stack top: %s\n", stack_peek(&s));
-    }
-    printf("-------------------------------\n");
+    reader_close(&reader);
+    unload_parsing_table(&table);
+    zeta_table_free(compiled);
+    return totals.accepted == totals.lines ? EXIT_SUCCESS : EXIT_FAILURE;
 }
-
-int main() {
-    // Use the CSV file generated by Parser.cpp (adjust path if needed)
-    load_parsing_table("ll1_parsing_table.csv"); 
-    FILE *input_file = fopen("input_strings.txt", "r");
-    if (!input_file) {
-        perror("Error opening input file");
-        return EXIT_FAILURE;
-    }
-
-    char line[MAX_INPUT_LEN];
-    while (fgets(line, sizeof(line), input_file)) {
-        line[strcspn(line, "\n")] = '\0'; // Remove newline
-        if (strlen(line) > 0) {
-            parse_input(line, "P"); // Assuming start symbol is 'E'
-        }
-    }
-
-    fclose(input_file);
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
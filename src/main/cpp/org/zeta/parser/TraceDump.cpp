@@ -0,0 +1,173 @@
+//
+// Pretty-prints a binary parse trace written by `Stack --trace=steps`.
+// The stack is rebuilt by replaying the records against the table stored in the
+// trace, so the output matches what `Stack --trace=verbose` prints for the same steps.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "ParseTableFormat.h"
+#include "ParseTrace.h"
+
+// Trace file loaded into memory
+typedef struct {
+    std::vector<char> data;
+    const ZLL1Header *table;
+    size_t records_offset;                  // first segment
+} TraceFile;
+
+void load_trace(TraceFile *trace, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("Error opening trace file");
+        exit(EXIT_FAILURE);
+    }
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        trace->data.insert(trace->data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    TraceFileHeader header;
+    if (trace->data.size() < sizeof(header)) {
+        fprintf(stderr, "Error: %s: not a parse trace\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&header, trace->data.data(), sizeof(header));
+    if (header.magic != ZTRC_MAGIC || header.version != ZTRC_VERSION) {
+        fprintf(stderr, "Error: %s: not a parse trace or unsupported version\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    if (header.table_size > trace->data.size() - sizeof(header)) {
+        fprintf(stderr, "Error: %s: truncated trace\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *error = NULL;
+    const char *table = trace->data.data() + sizeof(header);
+    if (!zll1_validate(table, header.table_size, &error)) {
+        fprintf(stderr, "Error: %s: embedded table: %s\n", filename, error);
+        exit(EXIT_FAILURE);
+    }
+    trace->table = (const ZLL1Header *)table;
+    trace->records_offset = sizeof(header) + header.table_size;
+}
+
+const char* name_of(const ZLL1Header *table, int id) {
+    if (id < 0 || id >= (int)table->num_symbols) return "<unknown token>";
+    return zll1_strings(table) + zll1_symbols(table)[id].name_offset;
+}
+
+// Print one segment, replaying its records on a rebuilt stack
+void print_segment(const ZLL1Header *table, const TraceRecord *records, uint64_t count) {
+    const ZLL1Production *productions = zll1_productions(table);
+    const int32_t *rhs = zll1_rhs(table);
+    std::vector<int32_t> stack;
+    bool stack_known = false;               // false until a BEGIN record is seen
+
+    for (uint64_t i = 0; i < count; i++) {
+        const TraceRecord &r = records[i];
+        const char *lookahead = name_of(table, r.lookahead);
+
+        if (r.kind == TRACE_BEGIN) {
+            stack.assign({zll1_find_symbol(table, "$", 1), r.top});
+            stack_known = true;
+            printf("\nParsing: line %d\n", r.arg);
+            printf("-------------------------------\n");
+            continue;
+        }
+        if (r.kind == TRACE_END) {
+            printf(r.arg == PARSE_ACCEPTED ? "\nParsing succeeded.\n" : "\nParsing failed with errors.\n");
+            printf("-------------------------------\n");
+            stack_known = false;
+            continue;
+        }
+
+        // the post-loop checks of the driver are not steps of their own
+        bool final_check = r.kind == TRACE_ERROR && r.arg != PARSE_NO_PRODUCTION;
+        if (!final_check) {
+            printf("Step %u:\n", r.step);
+            if (stack_known && stack.size() == r.depth && stack.back() == r.top) {
+                printf("Stack: ");
+                for (size_t k = stack.size(); k-- > 0;) printf("%s ", name_of(table, stack[k]));
+                printf("\n");
+            } else {
+                // the start of the parse was lost to ring wrap-around
+                stack_known = false;
+                printf("Stack: %s ... (%u symbols)\n", name_of(table, r.top), r.depth);
+            }
+            printf("Input: %s\n", lookahead);
+        }
+
+        switch (r.kind) {
+            case TRACE_EXPAND: {
+                const ZLL1Production &p = productions[r.arg];
+                printf("Action: Expand %s -> %s\n", name_of(table, r.top), zll1_strings(table) + p.text_offset);
+                if (stack_known) {
+                    stack.pop_back();
+                    stack.insert(stack.end(), rhs + p.rhs_offset, rhs + p.rhs_offset + p.rhs_length);
+                }
+                break;
+            }
+            case TRACE_MATCH:
+                printf("Action: Match '%s'\n", lookahead);
+                if (stack_known) stack.pop_back();
+                break;
+            case TRACE_ACCEPT:
+                printf("Action: Accept\n");
+                break;
+            case TRACE_ERROR:
+                if (r.arg == PARSE_NO_PRODUCTION) {
+                    printf("Error: No production for %s on input '%s'\n", name_of(table, r.top), lookahead);
+                } else if (r.arg == PARSE_INPUT_REMAINING) {
+                    printf("Error: Stack accepted but input remaining: %s\n", lookahead);
+                } else {
+                    printf("Error: Input exhausted but stack not empty. Top: %s\n", name_of(table, r.top));
+                }
+                break;
+            default:
+                printf("Unknown record kind %u\n", r.kind);
+                break;
+        }
+        if (r.kind == TRACE_EXPAND || r.kind == TRACE_MATCH) printf("\n");
+    }
+}
+
+// usage: TraceDump [trace-file]   (default parse_trace.bin)
+int main(int argc, char *argv[]) {
+    const char *trace_path = argc > 1 ? argv[1] : "parse_trace.bin";
+
+    TraceFile trace;
+    load_trace(&trace, trace_path);
+
+    size_t offset = trace.records_offset;
+    int segment_number = 0;
+    while (offset < trace.data.size()) {
+        TraceSegmentHeader segment;
+        if (trace.data.size() - offset < sizeof(segment)) break;
+        memcpy(&segment, trace.data.data() + offset, sizeof(segment));
+        offset += sizeof(segment);
+        if (segment.record_count > (trace.data.size() - offset) / sizeof(TraceRecord)) {
+            fprintf(stderr, "Error: %s: truncated segment %d\n", trace_path, segment_number + 1);
+            return EXIT_FAILURE;
+        }
+
+        std::vector<TraceRecord> records(segment.record_count);
+        if (!records.empty()) {
+            memcpy(records.data(), trace.data.data() + offset, records.size() * sizeof(TraceRecord));
+        }
+        offset += records.size() * sizeof(TraceRecord);
+
+        printf("=== Segment %d: %llu records", ++segment_number, (unsigned long long)segment.record_count);
+        if (segment.dropped) printf(", %llu earlier records dropped", (unsigned long long)segment.dropped);
+        printf(" ===\n");
+        print_segment(trace.table, records.data(), records.size());
+    }
+
+    if (offset != trace.data.size()) {
+        fprintf(stderr, "Warning: %s: trailing bytes after the last segment\n", trace_path);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+//
+// C API of the parser library (ZetaParser.h): Grammar.h behind opaque handles for building and
+// analysing grammars, ParseDriver for tables and parsing.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ZetaParser.h"
+#include "Grammar.h"
+#include "ParseDriver.h"
+
+static_assert(ZETA_TABLE_COMPRESSED == ZLL1_FLAG_COMPRESSED_ACTIONS, "table flags are passed through");
+static_assert(ZETA_TABLE_DEFAULT_PRODUCTIONS == ZLL1_FLAG_DEFAULT_PRODUCTIONS, "table flags are passed through");
+static_assert(ZETA_TABLE_EXPANSION_CHAINS == ZLL1_FLAG_EXPANSION_CHAINS, "table flags are passed through");
+
+#define ZETA_ALL_TRANSFORMS (ZETA_DEFAULT_TRANSFORMS | ZETA_INLINE)
+#define ZETA_ALL_TABLE_FLAGS (ZETA_TABLE_COMPRESSED | ZETA_TABLE_DEFAULT_PRODUCTIONS | ZETA_TABLE_EXPANSION_CHAINS)
+
+struct ZetaGrammar {
+    Grammar grammar;
+    std::ostringstream messages;            // Grammar's diagnostics
+    std::string messages_text;              // what zeta_grammar_messages last returned
+    bool analysed = false;
+};
+
+struct ZetaTable {
+    ParsingTable table = {};                // table.image owns the ZLL1 image
+};
+
+struct ZetaParser {
+    const ParsingTable *table;
+    ParseWorker worker;
+    OutputBuffer output;
+};
+
+static thread_local std::string last_error;
+
+static void set_error(const std::string &message) {
+    last_error = message;
+    // Grammar's diagnostics end in a newline, the message does not
+    while (!last_error.empty() && last_error.back() == '\n') last_error.pop_back();
+}
+
+// For the catch handlers: must not throw itself, so an unstorable message leaves ""
+static void set_error(const char *message) noexcept {
+    try {
+        last_error = message;
+    } catch (...) {
+        last_error.clear();
+    }
+}
+
+// Run the body of an entry point. Grammar, the IR and the standard containers allocate
+// through throwing allocators, and no exception may cross the C ABI into C or JNI callers:
+// anything thrown becomes failure and a message for zeta_last_error.
+template <typename T, typename F>
+static T guarded(T failure, F &&body) noexcept {
+    try {
+        return body();
+    } catch (const std::exception &e) {
+        set_error(e.what());
+    } catch (...) {
+        set_error("unknown exception");
+    }
+    return failure;
+}
+
+uint32_t zeta_api_version(void) {
+    return ZETA_API_VERSION;
+}
+
+const char *zeta_last_error(void) {
+    return last_error.c_str();
+}
+
+static ZetaGrammar *read_grammar(std::istream &in, const char *source) {
+    std::unique_ptr<ZetaGrammar> g(new ZetaGrammar);
+    g->grammar.diagnostics = &g->messages;
+    if (!g->grammar.readGrammar(in)) {
+        set_error(std::string(source) + ": " + g->messages.str());
+        return NULL;
+    }
+    if (g->grammar.ir.nonTerminalsByName().empty()) {
+        set_error(std::string(source) + ": the grammar has no rules");
+        return NULL;
+    }
+    return g.release();
+}
+
+// Read a grammar file in the cfg.txt format
+ZetaGrammar *zeta_grammar_load(const char *path) {
+    return guarded<ZetaGrammar *>(NULL, [&]() -> ZetaGrammar * {
+        if (!path) {
+            set_error("zeta_grammar_load: no path");
+            return NULL;
+        }
+        std::ifstream file(path);
+        if (!file) {
+            set_error(std::string("could not open ") + path);
+            return NULL;
+        }
+        return read_grammar(file, path);
+    });
+}
+
+// Read a grammar from memory, in the cfg.txt format
+ZetaGrammar *zeta_grammar_parse(const char *text, size_t length) {
+    return guarded<ZetaGrammar *>(NULL, [&]() -> ZetaGrammar * {
+        if (!text && length > 0) {
+            set_error("zeta_grammar_parse: no text");
+            return NULL;
+        }
+        std::istringstream in(std::string(text ? text : "", length));
+        return read_grammar(in, "grammar text");
+    });
+}
+
+// Run the requested transformations in Parser's order, then drop the arena words they left behind
+int zeta_grammar_transform(ZetaGrammar *g, uint32_t transforms) {
+    return guarded(-1, [&]() -> int {
+        if (!g) {
+            set_error("zeta_grammar_transform: no grammar");
+            return -1;
+        }
+        if (transforms & ~ZETA_ALL_TRANSFORMS) {
+            set_error("zeta_grammar_transform: unknown transformation flags");
+            return -1;
+        }
+        if (g->analysed) {
+            set_error("zeta_grammar_transform: the grammar has already been analysed");
+            return -1;
+        }
+        if (transforms & ZETA_LEFT_FACTOR) factorLeft(g->grammar.ir);
+        if (transforms & ZETA_ELIMINATE_LEFT_RECURSION) eliminateLeftRecursion(g->grammar.ir);
+        if (transforms & ZETA_REDUCE) {
+            GrammarReduction reduction;
+            reduceGrammar(g->grammar.ir, reduction);
+        }
+        if (transforms & ZETA_INLINE) {
+            InliningReport inlined;
+            g->grammar.inlineRules(inlined);
+        }
+        g->grammar.ir.compact();
+        return 0;
+    });
+}
+
+// FIRST, FOLLOW and the table; conflicts are reported to the grammar's messages
+int zeta_grammar_analyze(ZetaGrammar *g) {
+    return guarded(-1, [&]() -> int {
+        if (!g) {
+            set_error("zeta_grammar_analyze: no grammar");
+            return -1;
+        }
+        if (!g->analysed) {
+            Grammar &grammar = g->grammar;
+            grammar.computeFirst();
+            grammar.computeFollow();
+            if (grammar.startIndex < 0) {
+                set_error(g->messages.str());
+                return -1;
+            }
+            grammar.computeParsingTable();
+            g->analysed = true;
+        }
+        return (int)g->grammar.conflicts.size();
+    });
+}
+
+const char *zeta_grammar_messages(const ZetaGrammar *g) {
+    return guarded<const char *>("", [&]() -> const char * {
+        if (!g) return "";
+        ZetaGrammar *grammar = const_cast<ZetaGrammar *>(g);
+        grammar->messages_text = grammar->messages.str();
+        return grammar->messages_text.c_str();
+    });
+}
+
+void zeta_grammar_free(ZetaGrammar *g) {
+    delete g;
+}
+
+// Take ownership of a ZLL1 image, checking its layout and every value the driver follows
+// first, so a corrupt or crafted image is an error rather than an exit or an invalid read
+static ZetaTable *attach_image(std::vector<char> &&image, const char *source) {
+    const char *error = NULL;
+    if (!zll1_validate(image.data(), image.size(), &error) || !zll1_check_contents(image.data(), &error)) {
+        set_error(std::string(source) + ": " + error);
+        return NULL;
+    }
+    ZetaTable *t = new ZetaTable;
+    t->table.image = std::move(image);
+    load_parsing_table_image(&t->table, t->table.image.data(), t->table.image.size());
+    return t;
+}
+
+// Compile the table of a grammar, analysing it first if needed
+ZetaTable *zeta_table_compile(ZetaGrammar *g, uint32_t flags) {
+    return guarded<ZetaTable *>(NULL, [&]() -> ZetaTable * {
+        if (flags & ~ZETA_ALL_TABLE_FLAGS) {
+            set_error("zeta_table_compile: unknown table flags");
+            return NULL;
+        }
+        if (zeta_grammar_analyze(g) < 0) return NULL;
+        return attach_image(g->grammar.parsingTableImage(flags), "compiled table");
+    });
+}
+
+// Read a binary table written by Parser (ll1_parsing_table.bin)
+ZetaTable *zeta_table_load(const char *path) {
+    return guarded<ZetaTable *>(NULL, [&]() -> ZetaTable * {
+        if (!path) {
+            set_error("zeta_table_load: no path");
+            return NULL;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            set_error(std::string("could not open ") + path);
+            return NULL;
+        }
+        file.seekg(0, std::ios::end);
+        std::vector<char> image((size_t)file.tellg());
+        file.seekg(0);
+        if (!file.read(image.data(), (std::streamsize)image.size())) {
+            set_error(std::string("could not read ") + path);
+            return NULL;
+        }
+        return attach_image(std::move(image), path);
+    });
+}
+
+// Copy a ZLL1 image from memory
+ZetaTable *zeta_table_from_image(const void *data, size_t size) {
+    return guarded<ZetaTable *>(NULL, [&]() -> ZetaTable * {
+        if (!data) {
+            set_error("zeta_table_from_image: no data");
+            return NULL;
+        }
+        const char *bytes = (const char *)data;
+        return attach_image(std::vector<char>(bytes, bytes + size), "table image");
+    });
+}
+
+const void *zeta_table_image(const ZetaTable *t, size_t *size) {
+    if (size) *size = t ? t->table.image.size() : 0;
+    return t ? t->table.image.data() : NULL;
+}
+
+void zeta_table_free(ZetaTable *t) {
+    if (!t) return;
+    unload_parsing_table(&t->table);
+    delete t;
+}
+
+// Parse state for one thread; its report goes to an output buffer instead of stdout
+ZetaParser *zeta_parser_new(const ZetaTable *t) {
+    if (!t) {
+        set_error("zeta_parser_new: no table");
+        return NULL;
+    }
+    ZetaParser *p = (ZetaParser *)calloc(1, sizeof(ZetaParser));
+    if (!p) {
+        set_error("out of memory");
+        return NULL;
+    }
+    p->table = &t->table;
+    worker_init(&p->worker);
+    p->worker.output = &p->output;
+    return p;
+}
+
+// Parse every non-empty line of input
+int zeta_parse(ZetaParser *p, const char *input, size_t length, ZetaParseResult *result) {
+    return guarded(-1, [&]() -> int {
+        if (!p || (!input && length > 0)) {
+            set_error("zeta_parse: no parser or input");
+            return -1;
+        }
+        p->output.size = 0;
+        if (p->output.data) p->output.data[0] = '\0';
+        ParseTotals before = p->worker.totals;
+
+        TokenReader reader;
+        reader_open_range(&reader, input, input + length, 0);
+        while (reader_next_line(&reader)) parse_input(p->table, &p->worker, &reader);
+        reader_close(&reader);
+
+        const ParseTotals &after = p->worker.totals;
+        size_t lines = after.lines - before.lines;
+        size_t accepted = after.accepted - before.accepted;
+        if (result) {
+            result->lines = lines;
+            result->accepted = accepted;
+            result->tokens = after.tokens - before.tokens;
+            result->steps = after.steps - before.steps;
+        }
+        return accepted == lines ? 1 : 0;
+    });
+}
+
+const char *zeta_parser_output(const ZetaParser *p, size_t *size) {
+    bool empty = !p || !p->output.data;
+    if (size) *size = empty ? 0 : p->output.size;
+    return empty ? "" : p->output.data;
+}
+
+void zeta_parser_free(ZetaParser *p) {
+    if (!p) return;
+    worker_free(&p->worker);
+    free(p->output.data);
+    free(p);
+}
@@ -0,0 +1,111 @@
+//
+// C API of the parser library (the ZetaParser and zeta_parser CMake targets): build a grammar,
+// compile its LL(1) table and parse token streams in-process, without running Parser and Stack
+// and handing ll1_parsing_table.bin / .csv between them.
+//
+// The header is plain C with opaque handles, so it can be used from C and C++ and bound from
+// other languages (JNI, Java's foreign function API, ctypes, ...) against libzeta_parser.
+//
+//   ZetaGrammar  a grammar read from cfg.txt-format text, transformed and analysed
+//   ZetaTable    a compiled table (the ZLL1 image of ParseTableFormat.h); never modified once
+//                created, so any number of threads can share it
+//   ZetaParser   the per-parse state of one thread: create one per thread and table
+//
+// Functions that can fail return NULL or a negative value and leave a message for
+// zeta_last_error. Handles are released with the matching *_free function; a table must
+// outlive the parsers created from it, a grammar need not outlive its tables.
+//
+// Typical use:
+//   ZetaGrammar *g = zeta_grammar_load("cfg.txt");
+//   zeta_grammar_transform(g, ZETA_DEFAULT_TRANSFORMS);
+//   ZetaTable *t = zeta_table_compile(g, 0);
+//   ZetaParser *p = zeta_parser_new(t);
+//   int accepted = zeta_parse(p, "id = num ;", 10, NULL);
+//
+#ifndef ZETA_PARSER_H
+#define ZETA_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define ZETA_API __attribute__((visibility("default")))
+#else
+#define ZETA_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a declaration below changes incompatibly
+#define ZETA_API_VERSION 1
+
+// Grammar transformations, in the order Parser runs them
+#define ZETA_LEFT_FACTOR                0x1u
+#define ZETA_ELIMINATE_LEFT_RECURSION   0x2u
+#define ZETA_REDUCE                     0x4u    // drop useless symbols, merge identical rules
+#define ZETA_INLINE                     0x8u    // Parser --inline
+#define ZETA_DEFAULT_TRANSFORMS (ZETA_LEFT_FACTOR | ZETA_ELIMINATE_LEFT_RECURSION | ZETA_REDUCE)
+
+// Table layouts (the ZLL1_FLAG_* bits of ParseTableFormat.h)
+#define ZETA_TABLE_COMPRESSED           0x1u    // Parser --compress-table
+#define ZETA_TABLE_DEFAULT_PRODUCTIONS  0x2u    // Parser --default-productions
+#define ZETA_TABLE_EXPANSION_CHAINS     0x4u    // Parser --expansion-chains
+
+typedef struct ZetaGrammar ZetaGrammar;
+typedef struct ZetaTable ZetaTable;
+typedef struct ZetaParser ZetaParser;
+
+// Counts of one zeta_parse call
+typedef struct {
+    size_t lines;                           // non-empty lines parsed
+    size_t accepted;
+    size_t tokens;
+    size_t steps;
+} ZetaParseResult;
+
+ZETA_API uint32_t zeta_api_version(void);
+
+// Message of the last failed call on this thread ("" if none)
+ZETA_API const char *zeta_last_error(void);
+
+// Grammar
+// zeta_grammar_load / _parse read cfg.txt-format rules ("A -> x B | ε", one rule per line).
+// zeta_grammar_transform runs the given ZETA_* transformations; it must come before the analysis.
+// zeta_grammar_analyze computes FIRST, FOLLOW and the table and returns the number of
+// conflicting cells (0 for an LL(1) grammar), or -1 on error. It is run by zeta_table_compile
+// when needed; a conflicting cell keeps the last production claiming it, as in Parser.
+// zeta_grammar_messages returns the warnings and conflict reports Parser would print.
+ZETA_API ZetaGrammar *zeta_grammar_load(const char *path);
+ZETA_API ZetaGrammar *zeta_grammar_parse(const char *text, size_t length);
+ZETA_API int zeta_grammar_transform(ZetaGrammar *grammar, uint32_t transforms);
+ZETA_API int zeta_grammar_analyze(ZetaGrammar *grammar);
+ZETA_API const char *zeta_grammar_messages(const ZetaGrammar *grammar);
+ZETA_API void zeta_grammar_free(ZetaGrammar *grammar);
+
+// Table
+// zeta_table_compile builds the table of an analysed grammar with ZETA_TABLE_* flags.
+// zeta_table_load reads a table written by Parser (ll1_parsing_table.bin); _from_image copies
+// one from memory. zeta_table_image returns the ZLL1 image, to store or ship elsewhere.
+ZETA_API ZetaTable *zeta_table_compile(ZetaGrammar *grammar, uint32_t flags);
+ZETA_API ZetaTable *zeta_table_load(const char *path);
+ZETA_API ZetaTable *zeta_table_from_image(const void *data, size_t size);
+ZETA_API const void *zeta_table_image(const ZetaTable *table, size_t *size);
+ZETA_API void zeta_table_free(ZetaTable *table);
+
+// Parsing
+// zeta_parse parses every non-empty line of input as one sentence of whitespace-separated
+// tokens. Returns 1 if all of them were accepted, 0 if any was rejected, -1 on error; result,
+// if not NULL, receives the counts. zeta_parser_output returns the report of that call, one
+// line per sentence as Stack prints it ("line 2: rejected at step 5: ..."), NUL-terminated.
+ZETA_API ZetaParser *zeta_parser_new(const ZetaTable *table);
+ZETA_API int zeta_parse(ZetaParser *parser, const char *input, size_t length, ZetaParseResult *result);
+ZETA_API const char *zeta_parser_output(const ZetaParser *parser, size_t *size);
+ZETA_API void zeta_parser_free(ZetaParser *parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ZETA_PARSER_H